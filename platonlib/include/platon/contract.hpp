@@ -1,7 +1,8 @@
 #pragma once
 
-#define PLATON_ABI(NAME, MEMBER)
+#include "platon/storage.hpp"
 
+#define PLATON_ABI(NAME, MEMBER)
 
 
 namespace platon {
@@ -9,6 +10,12 @@ namespace platon {
         public:
             Contract(){}
             virtual void init(){}
+        private:
+            /**
+             * @brief Buffer the state writes of the call, they are flushed after the members
+             * of the derived contract are destroyed.
+             */
+            StateScope stateScope_;
     };
 }
 
@@ -4,8 +4,9 @@
 
 #pragma once
 
-#include <map>
 #include "platon/storage.hpp"
+#include "platon/db/generation.hpp"
+#include "platon/db/cachetable.hpp"
 
 namespace platon {
 namespace db {
@@ -26,7 +27,7 @@ namespace db {
         class Iterator: public std::iterator<std::bidirectional_iterator_tag, Key> {
         public:
             friend bool operator == ( const Iterator& a, const Iterator& b ) {
-                return a.array_ == b.array_ && a.pos_ = b.pos_;
+                return a.array_ == b.array_ && a.pos_ == b.pos_;
             }
             friend bool operator != ( const Iterator& a, const Iterator& b ) {
                 return a.array_ != b.array_ || a.pos_ != b.pos_;
@@ -68,7 +69,6 @@ namespace db {
             Iterator operator --(int) {
                 PlatonAssert(pos_ > 0, "pos can't be negative");
                 Iterator tmp(array_, pos_--);
-                --tmp;
                 return tmp;
             }
 
@@ -79,7 +79,6 @@ namespace db {
 
             Iterator operator ++(int) {
                 Iterator tmp(array_, pos_++);
-                ++tmp;
                 return tmp;
             }
         private:
@@ -95,7 +94,7 @@ namespace db {
         class ConstIterator: public std::iterator<std::bidirectional_iterator_tag, const Key> {
         public:
             friend bool operator == ( const ConstIterator& a, const ConstIterator& b ) {
-                return a.array_ == b.array_ && a.pos_ = b.pos_;
+                return a.array_ == b.array_ && a.pos_ == b.pos_;
             }
             friend bool operator != ( const ConstIterator& a, const ConstIterator& b ) {
                 return a.array_ != b.array_ || a.pos_ != b.pos_;
@@ -139,7 +138,6 @@ namespace db {
             ConstIterator operator --(int) {
                 PlatonAssert(pos_ > 0, "pos can't be negative");
                 ConstIterator tmp(array_, pos_--);
-                --tmp;
                 return tmp;
             }
 
@@ -150,7 +148,6 @@ namespace db {
 
             ConstIterator operator ++(int) {
                 ConstIterator tmp(array_, pos_++);
-                ++tmp;
                 return tmp;
             }
         private:
@@ -167,7 +164,7 @@ namespace db {
         class ConstReverseIterator: public std::iterator<std::bidirectional_iterator_tag, const Key> {
         public:
             friend bool operator == ( const ConstReverseIterator& a, const ConstReverseIterator& b ) {
-                return a.array_ == b.array_ && a.pos_ = b.pos_;
+                return a.array_ == b.array_ && a.pos_ == b.pos_;
             }
             friend bool operator != ( const ConstReverseIterator& a, const ConstReverseIterator& b ) {
                 return a.array_ != b.array_ || a.pos_ != b.pos_;
@@ -211,7 +208,6 @@ namespace db {
             ConstReverseIterator operator --(int) {
                 PlatonAssert(pos_ > 0, "pos can't be negative");
                 ConstReverseIterator tmp(array_, pos_++);
-                ++tmp;
                 return tmp;
             }
 
@@ -222,7 +218,6 @@ namespace db {
 
             ConstReverseIterator operator ++(int) {
                 ConstReverseIterator tmp(array_, pos_--);
-                --tmp;
                 return tmp;
             }
         private:
@@ -242,8 +237,12 @@ namespace db {
         Array(const Array<Name, Key, Size> &&) = delete;
         Array<Name, Key, Size>& operator=(const Array<Name, Key, Size> &) = delete;
 
+        /**
+         * @brief Destroy the Array object. The cache is shared by the Array objects of the same
+         * name in the call and refreshed to blockchain once, see sharedState().
+         *
+         */
         ~Array() {
-            flush();
         }
 
         /**
@@ -326,15 +325,17 @@ namespace db {
          */
         Key& at(size_t pos) {
             PlatonAssert(pos < Size, "out of range pos:", pos, "size:", Size);
-            auto iter = cache_.find(pos);
-            if (iter != cache_.end()) {
-                return iter->second;
+            Entry *e = cache_.find(pos);
+            if (e != nullptr) {
+                return e->value;
             }
-            Key key;
-            getState(encodeKey(pos), key);
-            auto iterc = cache_.emplace(std::make_pair(pos, key));
-            PlatonAssert(iterc.second, "cache emplace failed");
-            return iterc.first->second;
+            if (cache_.full()) {
+                core_->spill();
+            }
+            Entry &entry = cache_.get(pos);
+            getState(encodeKey(pos), entry.value);
+            entry.snapshot = encodeState(entry.value);
+            return entry.value;
         }
 
         /**
@@ -363,11 +364,11 @@ namespace db {
          * @return Key Element value
          */
         Key getConst(size_t pos) {
-            auto iter = cache_.find(pos);
-            if (iter != cache_.end()) {
-                return iter->second;
+            Entry *e = cache_.find(pos);
+            if (e != nullptr) {
+                return e->value;
             }
-            Key key;
+            Key key = Key();
             getState(encodeKey(pos), key);
             return key;
         }
@@ -379,47 +380,189 @@ namespace db {
          * @param key 
          */
         void setConst(size_t pos, const Key &key) {
-            auto iter = cache_.find(pos);
-            if (iter != cache_.end()) {
-                cache_[pos] = key;
+            Entry *e = cache_.find(pos);
+            if (e != nullptr) {
+                e->value = key;
+                e->snapshot = encodeState(key);
             }
             setState(encodeKey(pos), key);
         }
 
+        /**
+         * @brief setConst() that moves the value into the cache if the position is cached
+         *
+         * @param pos
+         * @param key
+         */
+        void setConst(size_t pos, Key &&key) {
+            Entry *e = cache_.find(pos);
+            if (e == nullptr) {
+                setState(encodeKey(pos), key);
+                return;
+            }
+            e->value = std::move(key);
+            e->snapshot = encodeState(e->value);
+            setState(encodeKey(pos), e->value);
+        }
+
+        /**
+         * @brief Bound the cache of the array, shared by the Array objects of the call. Loading
+         * an element into a full cache writes back and evicts cold elements. A reference
+         * returned by at() may be invalidated by the second element loaded after it.
+         *
+         * @param entries Maximum number of cached elements, 0 is unbounded
+         */
+        void setCacheLimit(size_t entries) {
+            cache_.setLimit(entries);
+        }
+
+        /**
+         * @brief Reset all elements to their default value with a constant number of writes.
+         * The old elements become unreachable, sweep() deletes them from the blockchain.
+         *
+         */
+        void clear() {
+            generation().next();
+            cache_.clear();
+        }
+
+        /**
+         * @brief Delete up to limit elements left behind by clear()
+         *
+         * @param limit Maximum number of elements deleted
+         * @return size_t Number of elements deleted, 0 when nothing is left
+         */
+        size_t sweep(size_t limit) {
+            Generation &gen = generation();
+            if (!gen.pending()) {
+                return 0;
+            }
+            StateBatch batch;
+            size_t removed = 0;
+            while (gen.pending() && removed < limit) {
+                std::string name = gen.prefix(gen.swept());
+                for (; gen.cursor() < Size && removed < limit; ++removed) {
+                    batch.del(encodeKey(name, gen.cursor()));
+                    gen.step(1);
+                }
+                if (gen.cursor() >= Size) {
+                    gen.advance();
+                }
+            }
+            batch.commit();
+            gen.save();
+            return removed;
+        }
+
     private:
+        /**
+         * @brief Key prefix of the array
+         *
+         * @return const std::string&
+         */
+        static const std::string& prefix() {
+            static const std::string prefix = statePrefix<Name>(kType, 'a');
+            return prefix;
+        }
+
+        /**
+         * @brief Generation of the array
+         *
+         * @return Generation&
+         */
+        static Generation& generation() {
+            static Generation gen(prefix());
+            gen.load();
+            return gen;
+        }
+
         /**
          * @brief Generate the key of the specified index
          * 
          * @param index 
          * @return std::string 
          */
-        std::string encodeKey(size_t index) {
+        static std::string encodeKey(size_t index) {
+            return encodeKey(generation().prefix(), index);
+        }
+
+        /**
+         * @brief Generate the key of the specified index in a generation
+         *
+         * @param name Key prefix of the generation
+         * @param index
+         * @return std::string
+         */
+        static std::string encodeKey(const std::string &name, size_t index) {
             std::string key;
-            key.reserve(name_.length() + 1 + sizeof(index));
-            key.append(name_);
+            key.reserve(name.length() + 1 + sizeof(index));
+            key.append(name);
             key.append(1, 'A');
             key.append((char*)&index, sizeof(index));
             return key;
         }
 
     private:
+        typedef typename CacheTable<size_t, Key>::Entry Entry;
+
         /**
-         * @brief Refresh data to blockchain
-         * 
+         * @brief Elements shared by the Array objects of the call
+         *
          */
-        void flush() {
-            for (auto iter : cache_) {
-                std::string key = encodeKey(iter.first);
-                setState(key, iter.second);
+        struct Core {
+            ~Core() {
+                flush();
+            }
+
+            /**
+             * @brief Refresh data to blockchain, elements whose serialized value is unchanged are skipped
+             *
+             */
+            void flush() {
+                StateBatch batch;
+                for (Entry &e : cache) {
+                    write(batch, e);
+                }
+                batch.commit();
             }
-        }
+
+            /**
+             * @brief Drop the cached elements without writing them
+             *
+             */
+            void reload() {
+                cache.clear();
+                generation().reload();
+            }
+
+            /**
+             * @brief Evict cold elements, changed ones are written first
+             *
+             */
+            void spill() {
+                StateBatch batch;
+                cache.shrink([&](Entry &e) { write(batch, e); });
+                batch.commit();
+            }
+
+            static void write(StateBatch &batch, Entry &e) {
+                std::string bytes = encodeState(e.value);
+                if (bytes != e.snapshot) {
+                    batch.set(encodeKey(e.key), e.value);
+                    e.snapshot = std::move(bytes);
+                }
+            }
+
+            // snapshot of an entry is the serialized value read from the blockchain,
+            // a missing element as the default value
+            CacheTable<size_t, Key> cache;
+        };
 
     public:
         static const std::string kType;
     private:
-        std::map<size_t, Key> cache_;
-
-        const std::string name_ = kType + Name;
+        std::shared_ptr<Core> core_ = sharedState<Core>();
+        CacheTable<size_t, Key> &cache_ = core_->cache;
     };
 
 //    const std::string kType = "array"
@@ -0,0 +1,171 @@
+//
+// Bloom filter persisted in state, answers most lookups of missing keys without a host read
+//
+
+#pragma once
+
+#include <string>
+#include "platon/assert.h"
+#include "platon/storage.hpp"
+
+namespace platon {
+namespace db {
+    /**
+     * @brief Bloom filter of Bits bits with three hash functions. The bits are read from the
+     * blockchain on first use and written back by flush() when a key was added.
+     *
+     * A filter only answers after build(), which is called once while the container is empty
+     * or with all of its keys. Until then the filter does not exist on the blockchain, every
+     * key may exist and add() records nothing, so a container that held keys before the filter
+     * was enabled never loses one to a false negative.
+     *
+     * @tparam Bits Number of bits, a multiple of 8
+     */
+    template <unsigned Bits>
+    class BloomFilter {
+    public:
+        static_assert(Bits != 0 && Bits % 8 == 0, "bloom filter bits must be a multiple of 8");
+        static const unsigned kHashes = 3;
+
+        /**
+         * @brief Add a key
+         *
+         * @param key Key bytes
+         * @param len Key length
+         * @param stateKey Key of the filter on the blockchain
+         */
+        void add(const char *key, size_t len, const std::string &stateKey) {
+            load(stateKey);
+            if (!built_) {
+                return;
+            }
+            uint64_t h1, h2;
+            hash(key, len, h1, h2);
+            for (unsigned i = 0; i < kHashes; ++i) {
+                size_t bit = (h1 + i * h2) % Bits;
+                if ((bits_[bit / 8] & (1 << (bit % 8))) == 0) {
+                    bits_[bit / 8] |= (char)(1 << (bit % 8));
+                    dirty_ = true;
+                }
+            }
+        }
+
+        /**
+         * @brief Whether the key may have been added
+         *
+         * @param key Key bytes
+         * @param len Key length
+         * @param stateKey Key of the filter on the blockchain
+         * @return true The key may exist, always before build()
+         * @return false The key was never added
+         */
+        bool mayContain(const char *key, size_t len, const std::string &stateKey) {
+            load(stateKey);
+            if (!built_) {
+                return true;
+            }
+            uint64_t h1, h2;
+            hash(key, len, h1, h2);
+            for (unsigned i = 0; i < kHashes; ++i) {
+                size_t bit = (h1 + i * h2) % Bits;
+                if ((bits_[bit / 8] & (1 << (bit % 8))) == 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Write the bits if a key was added
+         *
+         * @param batch Batch of the container flush
+         * @param stateKey Key of the filter on the blockchain
+         */
+        void flush(StateBatch &batch, const std::string &stateKey) {
+            if (dirty_) {
+                batch.set(stateKey, bits_);
+                dirty_ = false;
+            }
+        }
+
+        /**
+         * @brief Start an empty filter, written by the next flush. The keys the container
+         * already holds have to be added afterwards.
+         *
+         */
+        void build() {
+            bits_.assign(Bits / 8, '\0');
+            loaded_ = true;
+            built_ = true;
+            dirty_ = true;
+        }
+
+        /**
+         * @brief Whether the filter was built
+         *
+         * @param stateKey Key of the filter on the blockchain
+         * @return true
+         * @return false
+         */
+        bool built(const std::string &stateKey) {
+            load(stateKey);
+            return built_;
+        }
+
+        /**
+         * @brief Drop the bits without writing them, they are read again when needed
+         *
+         */
+        void unload() {
+            bits_.clear();
+            loaded_ = false;
+            built_ = false;
+            dirty_ = false;
+        }
+
+    private:
+        void load(const std::string &stateKey) {
+            if (loaded_) {
+                return;
+            }
+            loaded_ = true;
+            built_ = platon::getState(stateKey, bits_) != 0;
+            PlatonAssert(!built_ || bits_.size() == Bits / 8, "bloom filter size mismatch, bits:", bits_.size() * 8, "expected:", Bits);
+        }
+
+        /**
+         * @brief Two FNV-1a hashes, combined by double hashing
+         *
+         */
+        static void hash(const char *key, size_t len, uint64_t &h1, uint64_t &h2) {
+            h1 = 14695981039346656037ULL;
+            h2 = 1099511628211ULL;
+            for (size_t i = 0; i < len; ++i) {
+                h1 = (h1 ^ (uint8_t)key[i]) * 1099511628211ULL;
+                h2 = (h2 ^ (uint8_t)key[i]) * 14029467366897019727ULL;
+            }
+            h2 |= 1;
+        }
+
+        std::string bits_;
+        bool loaded_ = false;
+        bool built_ = false;
+        bool dirty_ = false;
+    };
+
+    /**
+     * @brief No filter, every key may exist
+     *
+     */
+    template <>
+    class BloomFilter<0> {
+    public:
+        void add(const char *, size_t, const std::string &) {}
+        bool mayContain(const char *, size_t, const std::string &) { return true; }
+        void flush(StateBatch &, const std::string &) {}
+        void build() {}
+        bool built(const std::string &) { return false; }
+        void unload() {}
+    };
+}
+}
@@ -0,0 +1,330 @@
+//
+// Open addressing cache of container entries
+//
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "platon/storage.hpp"
+
+namespace platon {
+namespace db {
+    /**
+     * @brief Hash of a key. Integral and enum keys are multiplied, string keys hash their bytes
+     * so that std::string, bytes and StringRef of equal content agree, other keys hash their
+     * serialized form.
+     *
+     * @tparam Key Key type
+     */
+    template <typename Key, typename Enable = void>
+    struct KeyHash {
+        size_t operator()(const Key &k) const {
+            StateBytes<kStateKeyInline> bytes;
+            encodeState(bytes, k);
+            uint64_t hash = 14695981039346656037ULL;
+            for (size_t i = 0; i < bytes.size(); ++i) {
+                hash = (hash ^ (uint8_t)bytes.data()[i]) * 1099511628211ULL;
+            }
+            return (size_t)(hash ^ (hash >> 32));
+        }
+    };
+
+    template <typename Key>
+    struct KeyHash<Key, typename std::enable_if<std::is_integral<Key>::value || std::is_enum<Key>::value>::type> {
+        size_t operator()(const Key &k) const {
+            // spread sequential keys over the table
+            uint64_t hash = (uint64_t)k * 0x9E3779B97F4A7C15ULL;
+            return (size_t)(hash ^ (hash >> 32));
+        }
+    };
+
+    template <typename Key>
+    struct KeyHash<Key, typename std::enable_if<IsStringKey<Key>::value>::type> {
+        size_t operator()(const Key &k) const {
+            StringRef s(k);
+            uint64_t hash = 14695981039346656037ULL;
+            for (size_t i = 0; i < s.size(); ++i) {
+                hash = (hash ^ (uint8_t)s.data()[i]) * 1099511628211ULL;
+            }
+            return (size_t)(hash ^ (hash >> 32));
+        }
+    };
+
+    /**
+     * @brief Cache of the entries a container touched during a call. One linear probing table
+     * of 32-bit slots indexes entries kept in a deque, so references to values stay valid while
+     * the table grows.
+     *
+     * With a limit set, the container calls shrink() before adding a key to a full table.
+     * shrink() evicts cold entries with the CLOCK algorithm: an access sets the referenced bit
+     * of an entry, one turn of the hand clears the bits it passes and evicts entries whose bit
+     * was already clear, so the entries touched since the previous shrink() stay. Slots of
+     * evicted entries are reused by later keys.
+     *
+     * @tparam Key Key type, compared with operator<, string keys also with StringRef
+     * @tparam Value Value type
+     */
+    template <typename Key, typename Value>
+    class CacheTable {
+    public:
+        /**
+         * @brief Cached key and value with the state flags of the owning container
+         *
+         */
+        struct Entry {
+            Entry(const Key &k, size_t h) :key(k), hash(h) {}
+            Entry(Key &&k, size_t h) :key(std::move(k)), hash(h) {}
+
+            Key key;
+            Value value = Value();
+            std::string snapshot;
+            size_t hash;
+            uint8_t flags = 0;
+            bool referenced = true;
+            bool live = true;
+        };
+
+        /**
+         * @brief Iterator over the cached entries, evicted entries are skipped
+         *
+         */
+        class iterator {
+        public:
+            typedef typename std::deque<Entry>::iterator Base;
+
+            iterator(Base pos, Base end) :pos_(pos), end_(end) {
+                skip();
+            }
+
+            Entry& operator*() const { return *pos_; }
+            Entry* operator->() const { return &*pos_; }
+
+            iterator& operator++() {
+                ++pos_;
+                skip();
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const { return pos_ == other.pos_; }
+            bool operator!=(const iterator &other) const { return pos_ != other.pos_; }
+
+        private:
+            void skip() {
+                while (pos_ != end_ && !pos_->live) {
+                    ++pos_;
+                }
+            }
+
+            Base pos_;
+            Base end_;
+        };
+
+        /**
+         * @brief Entry of a key, or of a StringRef equal to a string key
+         *
+         * @param k Key
+         * @return Entry* nullptr if the key was never touched
+         */
+        template <typename K>
+        Entry* find(const K &k) {
+            if (slots_.empty()) {
+                return nullptr;
+            }
+            size_t h = KeyHash<K>()(k);
+            size_t mask = slots_.size() - 1;
+            for (size_t i = h & mask; slots_[i] != 0; i = (i + 1) & mask) {
+                Entry &e = entries_[slots_[i] - 1];
+                if (e.hash == h && equal(e.key, k)) {
+                    e.referenced = true;
+                    return &e;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief Entry of a key, created with no flags when the key is new
+         *
+         * @param k Key
+         * @return Entry&
+         */
+        Entry& get(const Key &k) {
+            return insert(k);
+        }
+
+        /**
+         * @brief Same as get(), a new entry takes over the key
+         *
+         */
+        Entry& get(Key &&k) {
+            return insert(std::move(k));
+        }
+
+        /**
+         * @brief Remove the entry of a key, references to it become invalid
+         *
+         * @param k Key
+         * @return true
+         * @return false The key was not cached
+         */
+        template <typename K>
+        bool erase(const K &k) {
+            Entry *e = find(k);
+            if (e == nullptr) {
+                return false;
+            }
+            release(*e);
+            return true;
+        }
+
+        /**
+         * @brief Set the number of entries above which shrink() evicts, 0 is unbounded
+         *
+         * @param entries Maximum number of entries
+         */
+        void setLimit(size_t entries) {
+            limit_ = entries;
+        }
+
+        size_t limit() const { return limit_; }
+
+        /**
+         * @brief Whether adding a key needs a shrink() first
+         *
+         */
+        bool full() const {
+            return limit_ != 0 && size_ >= limit_;
+        }
+
+        /**
+         * @brief Evict cold entries until three quarters of the limit are left or the hand
+         * made one turn. spill is called with every evicted entry before it is dropped.
+         *
+         * @param spill Callable taking Entry&, writes back what the entry changed
+         */
+        template <typename Spill>
+        void shrink(Spill &&spill) {
+            size_t target = limit_ * 3 / 4;
+            for (size_t n = 0; n < entries_.size() && size_ > target; ++n) {
+                if (hand_ >= entries_.size()) {
+                    hand_ = 0;
+                }
+                Entry &e = entries_[hand_++];
+                if (!e.live) {
+                    continue;
+                }
+                if (e.referenced) {
+                    e.referenced = false;
+                    continue;
+                }
+                spill(e);
+                release(e);
+            }
+        }
+
+        iterator begin() { return iterator(entries_.begin(), entries_.end()); }
+        iterator end() { return iterator(entries_.end(), entries_.end()); }
+        size_t size() const { return size_; }
+
+        void clear() {
+            entries_.clear();
+            slots_.clear();
+            free_.clear();
+            size_ = 0;
+            hand_ = 0;
+        }
+
+    private:
+        template <typename K>
+        Entry& insert(K &&k) {
+            if ((size_ + 1) * 10 > slots_.size() * 7) {
+                grow();
+            }
+            size_t h = KeyHash<Key>()(k);
+            size_t mask = slots_.size() - 1;
+            size_t i = h & mask;
+            for (; slots_[i] != 0; i = (i + 1) & mask) {
+                Entry &e = entries_[slots_[i] - 1];
+                if (e.hash == h && equal(e.key, k)) {
+                    e.referenced = true;
+                    return e;
+                }
+            }
+            ++size_;
+            if (free_.empty()) {
+                entries_.emplace_back(std::forward<K>(k), h);
+                slots_[i] = (uint32_t)entries_.size();
+                return entries_.back();
+            }
+            slots_[i] = free_.back() + 1;
+            free_.pop_back();
+            Entry &e = entries_[slots_[i] - 1];
+            e.key = std::forward<K>(k);
+            e.hash = h;
+            e.flags = 0;
+            e.referenced = true;
+            e.live = true;
+            return e;
+        }
+
+        /**
+         * @brief Drop an entry, the following slots of its probe sequence are shifted back
+         *
+         */
+        void release(Entry &e) {
+            size_t mask = slots_.size() - 1;
+            size_t i = e.hash & mask;
+            while (&entries_[slots_[i] - 1] != &e) {
+                i = (i + 1) & mask;
+            }
+            free_.push_back(slots_[i] - 1);
+            for (size_t j = (i + 1) & mask; slots_[j] != 0; j = (j + 1) & mask) {
+                size_t home = entries_[slots_[j] - 1].hash & mask;
+                // the entry at j stays unless its home is not cyclically within (i, j]
+                bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+                if (!stays) {
+                    slots_[i] = slots_[j];
+                    i = j;
+                }
+            }
+            slots_[i] = 0;
+            e.value = Value();
+            std::string().swap(e.snapshot);
+            e.live = false;
+            --size_;
+        }
+
+        template <typename K>
+        static bool equal(const Key &a, const K &b) {
+            return !(a < b) && !(b < a);
+        }
+
+        void grow() {
+            std::vector<uint32_t> slots(slots_.empty() ? 16 : slots_.size() * 2, 0);
+            size_t mask = slots.size() - 1;
+            for (size_t n = 0; n < entries_.size(); ++n) {
+                if (!entries_[n].live) {
+                    continue;
+                }
+                size_t i = entries_[n].hash & mask;
+                while (slots[i] != 0) {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = (uint32_t)(n + 1);
+            }
+            slots_.swap(slots);
+        }
+
+        std::deque<Entry> entries_;
+        std::vector<uint32_t> slots_;
+        std::vector<uint32_t> free_;     // positions of evicted entries in entries_
+        size_t size_ = 0;
+        size_t limit_ = 0;
+        size_t hand_ = 0;
+    };
+}
+}
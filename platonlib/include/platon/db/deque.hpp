@@ -0,0 +1,384 @@
+//
+// Double-ended queue stored in a ring of state slots
+//
+
+#pragma once
+
+#include <tuple>
+#include <vector>
+#include "platon/assert.h"
+#include "platon/storage.hpp"
+#include "platon/db/cachetable.hpp"
+
+namespace platon {
+namespace db {
+    /**
+     * @brief Double-ended queue. Element i is stored in slot head + i, head and tail are 64-bit
+     * counters that wrap around, so pushes and pops at both ends touch one slot and the
+     * counters, and nothing leaves a tombstone. Opening the deque reads only the counters,
+     * elements are read on access and written back when changed.
+     *
+     * The Deque objects of the same name share one cache during a call, see sharedState().
+     *
+     * Example:
+     * @code
+     * extern char tasksName[] = "tasks";
+     * platon::db::Deque<tasksName, std::string> tasks;
+     * tasks.push_back("task");
+     * std::string next = tasks.front();
+     * tasks.pop_front();
+     * @endcode
+     *
+     * @tparam Name Deque name, in the same contract, the name should be unique
+     * @tparam T Element type
+     */
+    template <const char *Name, typename T>
+    class Deque {
+    public:
+        static const std::string kType;
+
+        Deque() {}
+        Deque(const Deque &) = delete;
+        Deque& operator=(const Deque &) = delete;
+
+        /**
+         * @brief Destroy the Deque object. The cache is written to the blockchain once the
+         * last Deque object of the call is gone.
+         *
+         */
+        ~Deque() {
+        }
+
+        /**
+         * @brief Append an element
+         *
+         * @param t Element
+         */
+        void push_back(const T &t) {
+            store(core_->tail++) = t;
+        }
+
+        /**
+         * @brief Append an element, moved into the cache
+         *
+         * @param t Element
+         */
+        void push_back(T &&t) {
+            store(core_->tail++) = std::move(t);
+        }
+
+        /**
+         * @brief Prepend an element
+         *
+         * @param t Element
+         */
+        void push_front(const T &t) {
+            store(--core_->head) = t;
+        }
+
+        /**
+         * @brief Prepend an element, moved into the cache
+         *
+         * @param t Element
+         */
+        void push_front(T &&t) {
+            store(--core_->head) = std::move(t);
+        }
+
+        /**
+         * @brief Append an element constructed from args
+         *
+         * @param args Arguments of a T constructor
+         */
+        template <typename... Args>
+        void emplace_back(Args&&... args) {
+            push_back(T(std::forward<Args>(args)...));
+        }
+
+        /**
+         * @brief Prepend an element constructed from args
+         *
+         * @param args Arguments of a T constructor
+         */
+        template <typename... Args>
+        void emplace_front(Args&&... args) {
+            push_front(T(std::forward<Args>(args)...));
+        }
+
+        /**
+         * @brief Remove the last element
+         *
+         */
+        void pop_back() {
+            PlatonAssert(!empty(), "pop_back of empty deque", prefix());
+            remove(--core_->tail);
+        }
+
+        /**
+         * @brief Remove the first element
+         *
+         */
+        void pop_front() {
+            PlatonAssert(!empty(), "pop_front of empty deque", prefix());
+            remove(core_->head++);
+        }
+
+        /**
+         * @brief Element at an index, read into the cache and written back if changed
+         *
+         * @param index Index from the front
+         * @return T&
+         */
+        T& at(size_t index) {
+            PlatonAssert(index < size(), "out of range index:", index, "size:", size());
+            return load(core_->head + index);
+        }
+
+        T& operator[](size_t index) {
+            return at(index);
+        }
+
+        T& front() {
+            return at(0);
+        }
+
+        T& back() {
+            return at(size() - 1);
+        }
+
+        /**
+         * @brief Element at an index without caching it
+         *
+         * @param index Index from the front
+         * @return T
+         */
+        T getConst(size_t index) {
+            PlatonAssert(index < size(), "out of range index:", index, "size:", size());
+            uint64_t slot = core_->head + index;
+            Entry *e = cache_.find(slot);
+            if (e != nullptr && (e->flags & kCached)) {
+                return e->value;
+            }
+            T t = T();
+            platon::getState(slotKey(slot), t);
+            return t;
+        }
+
+        size_t size() const {
+            return (size_t)(core_->tail - core_->head);
+        }
+
+        bool empty() const {
+            return core_->tail == core_->head;
+        }
+
+        /**
+         * @brief Remove every element, each slot is deleted
+         *
+         */
+        void clear() {
+            while (!empty()) {
+                pop_back();
+            }
+        }
+
+        /**
+         * @brief Bound the cache of the deque. Caching an element in a full cache writes back
+         * and evicts cold elements. A reference returned by at() may be invalidated by the
+         * second element cached after it.
+         *
+         * @param entries Maximum number of cached elements, 0 is unbounded
+         */
+        void setCacheLimit(size_t entries) {
+            cache_.setLimit(entries);
+        }
+
+        /**
+         * @brief Write the changed elements and the counters
+         *
+         */
+        void flush() {
+            core_->flush();
+        }
+
+    private:
+        enum : uint8_t {
+            kCached = 1,    // value is loaded or written
+            kDirty = 2,     // value is written by flush
+            kDeleted = 4    // slot is deleted by flush
+        };
+
+        typedef typename CacheTable<uint64_t, T>::Entry Entry;
+
+        /**
+         * @brief Key prefix of the deque, also the key of the counters
+         *
+         * @return const std::string&
+         */
+        static const std::string& prefix() {
+            static const std::string prefix = statePrefix<Name>(kType, 'd');
+            return prefix;
+        }
+
+        /**
+         * @brief Key of a slot
+         *
+         * @param slot Slot number
+         * @return std::string
+         */
+        static std::string slotKey(uint64_t slot) {
+            const std::string &name = prefix();
+            std::string key;
+            key.reserve(name.length() + 1 + sizeof(slot));
+            key.append(name);
+            key.append(1, 'D');
+            key.append((const char*)&slot, sizeof(slot));
+            return key;
+        }
+
+        /**
+         * @brief Cache entry of a slot, cold entries are written back and evicted first when
+         * the cache is full
+         *
+         */
+        Entry& entry(uint64_t slot) {
+            if (cache_.full() && cache_.find(slot) == nullptr) {
+                core_->spill();
+            }
+            return cache_.get(slot);
+        }
+
+        /**
+         * @brief Value of a slot written by flush, whatever it held before
+         *
+         */
+        T& store(uint64_t slot) {
+            Entry &e = entry(slot);
+            e.flags = kCached | kDirty;
+            e.snapshot.clear();
+            return e.value;
+        }
+
+        /**
+         * @brief Value of a slot read from the blockchain once
+         *
+         */
+        T& load(uint64_t slot) {
+            Entry &e = entry(slot);
+            if (e.flags & kCached) {
+                return e.value;
+            }
+            e.value = T();
+            if (platon::getState(slotKey(slot), e.value) != 0) {
+                e.snapshot = encodeState(e.value);
+            }
+            e.flags = kCached;
+            return e.value;
+        }
+
+        /**
+         * @brief Delete a slot
+         *
+         */
+        void remove(uint64_t slot) {
+            Entry &e = entry(slot);
+            e.value = T();
+            e.snapshot.clear();
+            e.flags = kDeleted;
+        }
+
+        /**
+         * @brief Counters and elements shared by the Deque objects of the call
+         *
+         */
+        struct Core {
+            Core() {
+                load();
+            }
+
+            ~Core() {
+                flush();
+            }
+
+            void flush() {
+                StateBatch batch;
+                std::vector<uint64_t> deleted;
+                for (Entry &e : cache) {
+                    if (e.flags & kDeleted) {
+                        deleted.push_back(e.key);
+                    }
+                    write(batch, e);
+                }
+                for (uint64_t slot : deleted) {
+                    cache.erase(slot);
+                }
+                if (head != loadedHead || tail != loadedTail) {
+                    batch.set(prefix(), std::make_tuple(head, tail));
+                    loadedHead = head;
+                    loadedTail = tail;
+                }
+                batch.commit();
+            }
+
+            /**
+             * @brief Drop the cached elements without writing them and read the counters again
+             *
+             */
+            void reload() {
+                cache.clear();
+                load();
+            }
+
+            void load() {
+                std::tuple<uint64_t, uint64_t> counters(0, 0);
+                platon::getState(prefix(), counters);
+                head = loadedHead = std::get<0>(counters);
+                tail = loadedTail = std::get<1>(counters);
+            }
+
+            /**
+             * @brief Evict cold elements, changed ones are written first
+             *
+             */
+            void spill() {
+                StateBatch batch;
+                cache.shrink([&](Entry &e) { write(batch, e); });
+                batch.commit();
+            }
+
+            /**
+             * @brief Add the change of an element to a batch. A written element becomes clean,
+             * deleted ones are dropped by the caller.
+             *
+             */
+            static void write(StateBatch &batch, Entry &e) {
+                if (e.flags & kDeleted) {
+                    batch.del(slotKey(e.key));
+                } else if (e.flags & kDirty) {
+                    batch.set(slotKey(e.key), e.value);
+                    e.snapshot = encodeState(e.value);
+                    e.flags = kCached;
+                } else if (e.flags & kCached) {
+                    std::string bytes = encodeState(e.value);
+                    if (bytes != e.snapshot) {
+                        batch.set(slotKey(e.key), e.value);
+                        e.snapshot = std::move(bytes);
+                    }
+                }
+            }
+
+            uint64_t head = 0;          // slot of the first element
+            uint64_t tail = 0;          // slot after the last element
+            uint64_t loadedHead = 0;
+            uint64_t loadedTail = 0;
+            CacheTable<uint64_t, T> cache;
+        };
+
+        std::shared_ptr<Core> core_ = sharedState<Core>();
+        CacheTable<uint64_t, T> &cache_ = core_->cache;
+    };
+
+    template <const char *Name, typename T>
+    const std::string Deque<Name, T>::kType = "__deque__";
+}
+}
@@ -0,0 +1,340 @@
+//
+// Map of PLATON_SERIALIZE structs that stores every member under its own key
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "platon/storage.hpp"
+#include "platon/serialize.hpp"
+#include "platon/db/cachetable.hpp"
+
+namespace platon {
+namespace db {
+    /**
+     * @brief Map whose values are structs declared with PLATON_SERIALIZE. Member i of the value
+     * of key k is stored under (name, k, i), members are read on first access and flush() writes
+     * only the members whose serialized form changed. Members are numbered in the order of
+     * PLATON_SERIALIZE, new members can be appended but not reordered.
+     *
+     * Like Map::get(), reading a member of a missing value creates it with default members.
+     *
+     * Example:
+     * @code
+     * struct Account {
+     *     uint64_t balance;
+     *     std::string profile;
+     *     PLATON_SERIALIZE(Account, (balance)(profile))
+     * };
+     * extern char accountName[] = "account";
+     * platon::db::FieldMap<accountName, std::string, Account> accounts;
+     * accounts.field("alice", &Account::balance) += 10;   // profile is neither read nor written
+     * @endcode
+     *
+     * @tparam Name The name of the map, globally unique
+     * @tparam Key Key type
+     * @tparam Value Struct type, at most 64 members
+     */
+    template <const char *Name, typename Key, typename Value>
+    class FieldMap {
+    public:
+        static const std::string kType;
+
+        FieldMap() {}
+        FieldMap(const FieldMap &) = delete;
+        FieldMap& operator=(const FieldMap &) = delete;
+
+        /**
+         * @brief Destroy the FieldMap object. The cache is shared by the objects of the same
+         * name in the call and the changed members are written once, see sharedState().
+         *
+         */
+        ~FieldMap() {
+        }
+
+        /**
+         * @brief Insert or replace a value, every member is written
+         *
+         * @param k Key
+         * @param v Value
+         */
+        void insert(const Key &k, const Value &v) {
+            replace(k).value = v;
+        }
+
+        /**
+         * @brief Insert or replace a value, moved into the cache
+         *
+         * @param k Key
+         * @param v Value
+         */
+        void insert(const Key &k, Value &&v) {
+            replace(k).value = std::move(v);
+        }
+
+        /**
+         * @brief Value of a key with every member loaded
+         *
+         * @param k Key
+         * @return Value&
+         */
+        Value& get(const Key &k) {
+            Entry &e = entry(k);
+            for (size_t i = 0; i < fieldCount(); ++i) {
+                loadField(e, i);
+            }
+            return e.value.value;
+        }
+
+        Value& operator[](const Key &k) {
+            return get(k);
+        }
+
+        /**
+         * @brief One member of the value of a key, the other members are not read
+         *
+         * @param k Key
+         * @param member Pointer to a member listed in PLATON_SERIALIZE
+         * @return T&
+         */
+        template <typename T>
+        T& field(const Key &k, T Value::*member) {
+            Entry &e = entry(k);
+            loadField(e, fieldIndex(member));
+            return e.value.value.*member;
+        }
+
+        /**
+         * @brief Whether the key has a value. Every member key is checked until one is found.
+         *
+         * @param k Key
+         * @return true
+         * @return false
+         */
+        bool contains(const Key &k) {
+            const Entry *e = cache_.find(k);
+            if (e != nullptr && (e->flags & kDeleted)) {
+                return false;
+            }
+            if (e != nullptr && e->value.loaded != 0) {
+                return true;
+            }
+            for (size_t i = 0; i < fieldCount(); ++i) {
+                if (hasState(FieldKey(prefix(), k, (uint8_t)i))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Delete the value of a key, every member key is deleted by flush()
+         *
+         * @param k Key
+         */
+        void del(const Key &k) {
+            Entry &e = cache_.get(k);
+            Fields &f = e.value;
+            f.value = Value();
+            f.snapshots.assign(fieldCount(), std::string());
+            f.loaded = allFields();
+            f.dirty = 0;
+            e.flags = kDeleted;
+        }
+
+        /**
+         * @brief Write the members that changed
+         *
+         */
+        void flush() {
+            core_->flush();
+        }
+
+    private:
+        /**
+         * @brief Cached value, bit i of the masks is member i
+         *
+         */
+        struct Fields {
+            Value value = Value();
+            std::vector<std::string> snapshots;   // serialized members as read, empty if missing
+            uint64_t loaded = 0;
+            uint64_t dirty = 0;                   // written whatever their bytes
+        };
+
+        typedef typename CacheTable<Key, Fields>::Entry Entry;
+
+        enum : uint8_t {
+            kDeleted = 1    // every member key is deleted by flush
+        };
+
+        /**
+         * @brief Key of a member on the blockchain
+         *
+         */
+        class FieldKey {
+        public:
+            FieldKey(const std::string &name, const Key &key, uint8_t field)
+                :name_(name), key_(key), field_(field) {}
+            PLATON_SERIALIZE(FieldKey, (name_)(key_)(field_))
+        private:
+            const std::string &name_;
+            const Key &key_;
+            uint8_t field_;
+        };
+
+        static const std::string& prefix() {
+            static const std::string prefix = statePrefix<Name>(kType, 'f');
+            return prefix;
+        }
+
+        /**
+         * @brief Number of members listed in PLATON_SERIALIZE
+         *
+         */
+        static size_t fieldCount() {
+            static const size_t count = [] {
+                size_t n = 0;
+                forEachField(Value(), [&n](const auto &) { ++n; });
+                PlatonAssert(n <= 64, "too many members", prefix());
+                return n;
+            }();
+            return count;
+        }
+
+        static uint64_t allFields() {
+            return fieldCount() == 64 ? ~(uint64_t)0 : ((uint64_t)1 << fieldCount()) - 1;
+        }
+
+        /**
+         * @brief Position of a member in PLATON_SERIALIZE
+         *
+         */
+        template <typename T>
+        static size_t fieldIndex(T Value::*member) {
+            static const Value probe = Value();
+            const void *address = &(probe.*member);
+            size_t i = 0, index = fieldCount();
+            forEachField(probe, [&](const auto &m) {
+                if ((const void*)&m == address) {
+                    index = i;
+                }
+                ++i;
+            });
+            PlatonAssert(index < fieldCount(), "member not serialized", prefix());
+            return index;
+        }
+
+        /**
+         * @brief Cached value of a key whose members are all written by flush
+         *
+         */
+        Fields& replace(const Key &k) {
+            Entry &e = cache_.get(k);
+            Fields &f = e.value;
+            f.snapshots.resize(fieldCount());
+            f.loaded = f.dirty = allFields();
+            e.flags = 0;
+            return f;
+        }
+
+        /**
+         * @brief Cache entry of a key for access, a deleted value is recreated with default members
+         *
+         */
+        Entry& entry(const Key &k) {
+            Entry &e = cache_.get(k);
+            if (e.value.snapshots.empty()) {
+                e.value.snapshots.resize(fieldCount());
+            }
+            if (e.flags & kDeleted) {
+                e.flags = 0;
+                e.value.dirty = allFields();
+            }
+            return e;
+        }
+
+        /**
+         * @brief Read member i, once
+         *
+         */
+        void loadField(Entry &e, size_t i) {
+            Fields &f = e.value;
+            uint64_t bit = (uint64_t)1 << i;
+            if (f.loaded & bit) {
+                return;
+            }
+            f.loaded |= bit;
+            size_t j = 0;
+            forEachField(f.value, [&](auto &member) {
+                if (j++ == i && platon::getState(FieldKey(prefix(), e.key, (uint8_t)i), member) != 0) {
+                    f.snapshots[i] = encodeState(member);
+                }
+            });
+        }
+
+        /**
+         * @brief Cache of the map, shared by the FieldMap objects of the call
+         *
+         */
+        struct Core {
+            ~Core() {
+                flush();
+            }
+
+            /**
+             * @brief Write the members that changed, deleted values leave the cache
+             *
+             */
+            void flush() {
+                StateBatch batch;
+                std::vector<Key> deleted;
+                for (Entry &e : cache) {
+                    if (e.flags & kDeleted) {
+                        for (size_t i = 0; i < fieldCount(); ++i) {
+                            batch.del(FieldKey(prefix(), e.key, (uint8_t)i));
+                        }
+                        deleted.push_back(e.key);
+                        continue;
+                    }
+                    Fields &f = e.value;
+                    size_t i = 0;
+                    forEachField(f.value, [&](const auto &member) {
+                        uint64_t bit = (uint64_t)1 << i;
+                        if (f.loaded & bit) {
+                            std::string bytes = encodeState(member);
+                            if ((f.dirty & bit) || bytes != f.snapshots[i]) {
+                                batch.set(FieldKey(prefix(), e.key, (uint8_t)i), member);
+                                f.snapshots[i] = std::move(bytes);
+                            }
+                        }
+                        ++i;
+                    });
+                    f.dirty = 0;
+                }
+                for (const Key &k : deleted) {
+                    cache.erase(k);
+                }
+                batch.commit();
+            }
+
+            /**
+             * @brief Drop the cached values without writing them
+             *
+             */
+            void reload() {
+                cache.clear();
+            }
+
+            CacheTable<Key, Fields> cache;
+        };
+
+        std::shared_ptr<Core> core_ = sharedState<Core>();
+        CacheTable<Key, Fields> &cache_ = core_->cache;
+    };
+
+    template <const char *Name, typename Key, typename Value>
+    const std::string FieldMap<Name, Key, Value>::kType = "__fieldmap__";
+}
+}
@@ -0,0 +1,198 @@
+//
+// Generation of a container namespace, used for O(1) clear
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "platon/storage.hpp"
+#include "platon/serialize.hpp"
+
+namespace platon {
+namespace db {
+    /**
+     * @brief Key prefix generation of a container. clear() moves the container to the next
+     * generation, the entries of older generations are unreachable and deleted by sweep().
+     * Generation 0 uses the plain prefix, so containers that were never cleared keep their keys.
+     *
+     */
+    class Generation {
+    public:
+        /**
+         * @brief Persisted generation counters
+         *
+         */
+        struct Counter {
+            uint32_t current = 0;
+            uint32_t swept = 0;
+            uint64_t cursor = 0;
+            PLATON_SERIALIZE(Counter, (current)(swept)(cursor))
+        };
+
+        /**
+         * @brief Construct a new Generation object
+         *
+         * @param base Key prefix of generation 0
+         * @param suffixes Suffixes of the fixed keys of the container, see key()
+         */
+        Generation(const std::string &base, const std::vector<std::string> &suffixes = {})
+            :base_(base), stateKey_(base + "#generation"), prefix_(base), suffixes_(suffixes), keys_(suffixes.size()) {
+            for (size_t i = 0; i < suffixes_.size(); ++i) {
+                keys_[i] = prefix_ + suffixes_[i];
+            }
+        }
+
+        /**
+         * @brief Read the counters, only the first call reads the blockchain
+         *
+         */
+        void load() {
+            if (loaded_) {
+                return;
+            }
+            loaded_ = true;
+            platon::getState(stateKey_, counter_);
+            update();
+        }
+
+        /**
+         * @brief Read the counter again, after a Savepoint rollback
+         *
+         */
+        void reload() {
+            loaded_ = false;
+            counter_ = Counter();
+            load();
+        }
+
+        /**
+         * @brief Key prefix of the current generation. The string is updated in place by next().
+         *
+         * @return const std::string&
+         */
+        const std::string& prefix() const {
+            return prefix_;
+        }
+
+        /**
+         * @brief Key prefix of a generation
+         *
+         * @param generation Generation
+         * @return std::string
+         */
+        std::string prefix(uint32_t generation) const {
+            if (generation == 0) {
+                return base_;
+            }
+            char tag[5] = {'#', (char)(generation >> 24), (char)(generation >> 16),
+                           (char)(generation >> 8), (char)generation};
+            return base_ + std::string(tag, sizeof(tag));
+        }
+
+        /**
+         * @brief Fixed key of the current generation. The string is updated in place by next().
+         *
+         * @param i Index of the suffix
+         * @return const std::string&
+         */
+        const std::string& key(size_t i) const {
+            return keys_[i];
+        }
+
+        /**
+         * @brief Fixed key of a generation
+         *
+         * @param generation Generation
+         * @param i Index of the suffix
+         * @return std::string
+         */
+        std::string key(uint32_t generation, size_t i) const {
+            return prefix(generation) + suffixes_[i];
+        }
+
+        /**
+         * @brief Move to the next generation
+         *
+         */
+        void next() {
+            load();
+            PlatonAssert(counter_.current + 1 != 0, "generation overflow", base_);
+            ++counter_.current;
+            update();
+            save();
+        }
+
+        uint32_t current() const { return counter_.current; }
+
+        /**
+         * @brief Oldest generation that may still have entries
+         *
+         * @return uint32_t
+         */
+        uint32_t swept() const { return counter_.swept; }
+
+        /**
+         * @brief Number of entries of the swept generation already deleted
+         *
+         * @return uint64_t
+         */
+        uint64_t cursor() const { return counter_.cursor; }
+
+        /**
+         * @brief Whether older generations still have entries
+         *
+         * @return true
+         * @return false
+         */
+        bool pending() const { return counter_.swept < counter_.current; }
+
+        /**
+         * @brief Count entries deleted from the swept generation
+         *
+         * @param n Number of entries
+         */
+        void step(uint64_t n) { counter_.cursor += n; }
+
+        /**
+         * @brief Set the position in the swept generation
+         *
+         * @param cursor Position
+         */
+        void seek(uint64_t cursor) { counter_.cursor = cursor; }
+
+        /**
+         * @brief The swept generation is empty, continue with the next one
+         *
+         */
+        void advance() {
+            ++counter_.swept;
+            counter_.cursor = 0;
+        }
+
+        /**
+         * @brief Write the counters
+         *
+         */
+        void save() {
+            platon::setState(stateKey_, counter_);
+        }
+
+    private:
+        void update() {
+            prefix_ = prefix(counter_.current);
+            for (size_t i = 0; i < suffixes_.size(); ++i) {
+                keys_[i] = prefix_ + suffixes_[i];
+            }
+        }
+
+        const std::string &base_;
+        const std::string stateKey_;
+        std::string prefix_;
+        std::vector<std::string> suffixes_;
+        std::vector<std::string> keys_;
+        Counter counter_;
+        bool loaded_ = false;
+    };
+}
+}
@@ -0,0 +1,638 @@
+//
+// Sorted key index of a traversable map, a B+-tree of fixed size pages in state
+//
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "platon/storage.hpp"
+#include "platon/serialize.hpp"
+
+namespace platon {
+namespace db {
+    /**
+     * @brief B+-tree of keys stored in state. Every node holds at most PageSize keys and is
+     * stored under its own key, so insert and erase read and write O(log n) pages. Leaves are
+     * linked for iteration. Pages are loaded on demand and written back by flush().
+     *
+     * The meta data lives under prefix + "#btree", node i under prefix + "#node" + i.
+     * An index stored in the old format, one std::set under the prefix itself, is converted
+     * when it is loaded.
+     *
+     * @tparam Key Key type
+     * @tparam PageSize Maximum number of keys of a node
+     */
+    template <typename Key, unsigned PageSize = 64>
+    class KeyIndex {
+    public:
+        static_assert(PageSize >= 4 && PageSize < 0xffff, "page size out of range");
+
+        /**
+         * @brief Root, leaf list and size of the tree
+         *
+         */
+        struct Meta {
+            uint64_t root = 0;
+            uint64_t first = 0;
+            uint64_t last = 0;
+            uint64_t nextId = 1;
+            uint64_t size = 0;
+            PLATON_SERIALIZE(Meta, (root)(first)(last)(nextId)(size))
+        };
+
+        /**
+         * @brief Page of the tree. Leaves link their neighbours, in inner nodes keys[i]
+         * separates children[i] (smaller keys) and children[i + 1].
+         *
+         */
+        struct Node {
+            bool leaf = true;
+            std::vector<Key> keys;
+            std::vector<uint64_t> children;
+            uint64_t prev = 0;
+            uint64_t next = 0;
+            PLATON_SERIALIZE(Node, (leaf)(keys)(children)(prev)(next))
+        };
+
+        /**
+         * @brief Bidirectional iterator over the keys in order
+         *
+         */
+        class Iterator : public std::iterator<std::bidirectional_iterator_tag, const Key> {
+        public:
+            friend bool operator == (const Iterator &a, const Iterator &b) {
+                return a.index_ == b.index_ && a.leaf_ == b.leaf_ && a.pos_ == b.pos_;
+            }
+            friend bool operator != (const Iterator &a, const Iterator &b) {
+                return !(a == b);
+            }
+
+            Iterator() = default;
+
+            /**
+             * @brief Construct a new Iterator object
+             *
+             * @param index Index
+             * @param leaf Leaf id, 0 is the end
+             * @param pos Position in the leaf
+             */
+            Iterator(KeyIndex *index, uint64_t leaf, size_t pos)
+                :index_(index), leaf_(leaf), pos_(pos) {
+            }
+
+            const Key& operator*() const {
+                return index_->node(leaf_).keys[pos_];
+            }
+
+            const Key* operator->() const {
+                return &index_->node(leaf_).keys[pos_];
+            }
+
+            Iterator& operator++() {
+                const Node &n = index_->node(leaf_);
+                if (++pos_ >= n.keys.size()) {
+                    leaf_ = n.next;
+                    pos_ = 0;
+                }
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                Iterator tmp(*this);
+                ++*this;
+                return tmp;
+            }
+
+            Iterator& operator--() {
+                if (leaf_ == 0) {
+                    leaf_ = index_->meta_.last;
+                    pos_ = index_->node(leaf_).keys.size() - 1;
+                } else if (pos_ == 0) {
+                    leaf_ = index_->node(leaf_).prev;
+                    pos_ = index_->node(leaf_).keys.size() - 1;
+                } else {
+                    --pos_;
+                }
+                return *this;
+            }
+
+            Iterator operator--(int) {
+                Iterator tmp(*this);
+                --*this;
+                return tmp;
+            }
+        private:
+            KeyIndex *index_ = nullptr;
+            uint64_t leaf_ = 0;
+            size_t pos_ = 0;
+        };
+
+        typedef std::reverse_iterator<Iterator> ReverseIterator;
+
+        /**
+         * @brief Construct a new Key Index object
+         *
+         * @param prefix Key prefix, the string may change in place after reset()
+         */
+        explicit KeyIndex(const std::string &prefix) :prefix_(prefix) {}
+
+        KeyIndex(const KeyIndex &) = delete;
+        KeyIndex& operator=(const KeyIndex &) = delete;
+
+        /**
+         * @brief Read the meta data, convert an index in the old format
+         *
+         */
+        void load() {
+            if (loaded_) {
+                return;
+            }
+            loaded_ = true;
+            if (platon::getState(metaKey(prefix_), meta_) != 0) {
+                return;
+            }
+            std::set<Key> keys;
+            if (platon::getState(prefix_, keys) != 0) {
+                migrate(keys);
+            }
+        }
+
+        size_t size() {
+            load();
+            return meta_.size;
+        }
+
+        /**
+         * @brief Whether the key is in the index
+         *
+         * @param k Key, or a value comparable with keys such as StringRef for string keys
+         * @return true
+         * @return false
+         */
+        template <typename K>
+        bool contains(const K &k) {
+            load();
+            if (meta_.root == 0) {
+                return false;
+            }
+            uint64_t id = meta_.root;
+            while (!node(id).leaf) {
+                const Node &n = node(id);
+                id = n.children[std::upper_bound(n.keys.begin(), n.keys.end(), k) - n.keys.begin()];
+            }
+            const Node &n = node(id);
+            return std::binary_search(n.keys.begin(), n.keys.end(), k);
+        }
+
+        /**
+         * @brief Add a key
+         *
+         * @param k Key
+         * @return true The key is new
+         * @return false The key was in the index
+         */
+        bool insert(const Key &k) {
+            load();
+            if (meta_.root == 0) {
+                meta_.root = meta_.first = meta_.last = create(true);
+            }
+            Key split;
+            uint64_t right = 0;
+            if (!insertInto(meta_.root, k, split, right)) {
+                return false;
+            }
+            if (right != 0) {
+                uint64_t root = create(false);
+                Node &n = node(root);
+                n.keys.push_back(split);
+                n.children.push_back(meta_.root);
+                n.children.push_back(right);
+                meta_.root = root;
+            }
+            ++meta_.size;
+            metaDirty_ = true;
+            return true;
+        }
+
+        /**
+         * @brief Remove a key. Empty pages are removed, pages are not merged.
+         *
+         * @param k Key
+         * @return true The key was in the index
+         * @return false
+         */
+        bool erase(const Key &k) {
+            load();
+            if (meta_.root == 0) {
+                return false;
+            }
+            bool emptied = false;
+            if (!eraseFrom(meta_.root, k, emptied)) {
+                return false;
+            }
+            if (emptied) {
+                remove(meta_.root);
+                meta_.root = meta_.first = meta_.last = 0;
+            }
+            while (meta_.root != 0 && !node(meta_.root).leaf && node(meta_.root).children.size() == 1) {
+                uint64_t child = node(meta_.root).children[0];
+                remove(meta_.root);
+                meta_.root = child;
+            }
+            --meta_.size;
+            metaDirty_ = true;
+            return true;
+        }
+
+        Iterator begin() {
+            load();
+            if (meta_.first == 0 || node(meta_.first).keys.empty()) {
+                return end();
+            }
+            return Iterator(this, meta_.first, 0);
+        }
+
+        Iterator end() {
+            return Iterator(this, 0, 0);
+        }
+
+        /**
+         * @brief First key not less than k
+         *
+         */
+        Iterator lower_bound(const Key &k) {
+            return partition_point([&k](const Key &key) { return key < k; });
+        }
+
+        /**
+         * @brief First key greater than k
+         *
+         */
+        Iterator upper_bound(const Key &k) {
+            return partition_point([&k](const Key &key) { return !(k < key); });
+        }
+
+        /**
+         * @brief First key for which pred is false. The keys for which pred is true must come
+         * first, e.g. every key whose first member is less than a value.
+         *
+         * @param pred Predicate
+         * @return Iterator
+         */
+        template <typename Pred>
+        Iterator partition_point(Pred pred) {
+            load();
+            if (meta_.root == 0) {
+                return end();
+            }
+            uint64_t id = meta_.root;
+            while (!node(id).leaf) {
+                const Node &n = node(id);
+                id = n.children[std::partition_point(n.keys.begin(), n.keys.end(), pred) - n.keys.begin()];
+            }
+            const Node &n = node(id);
+            size_t pos = std::partition_point(n.keys.begin(), n.keys.end(), pred) - n.keys.begin();
+            if (pos == n.keys.size()) {
+                return Iterator(this, n.next, 0);
+            }
+            return Iterator(this, id, pos);
+        }
+
+        ReverseIterator rbegin() {
+            return ReverseIterator(end());
+        }
+
+        ReverseIterator rend() {
+            return ReverseIterator(begin());
+        }
+
+        /**
+         * @brief Write the changed pages
+         *
+         * @param batch Batch of the map flush
+         */
+        void flush(StateBatch &batch) {
+            for (uint64_t id : dirty_) {
+                batch.set(nodeKey(prefix_, id), nodes_[id]);
+            }
+            for (uint64_t id : removed_) {
+                batch.del(nodeKey(prefix_, id));
+            }
+            if (metaDirty_) {
+                batch.set(metaKey(prefix_), meta_);
+            }
+            if (migrated_) {
+                batch.del(prefix_);
+            }
+            dirty_.clear();
+            removed_.clear();
+            metaDirty_ = false;
+            migrated_ = false;
+        }
+
+        /**
+         * @brief Forget the index without writing it, used when the prefix moves to a new generation
+         *
+         */
+        void reset() {
+            nodes_.clear();
+            dirty_.clear();
+            removed_.clear();
+            meta_ = Meta();
+            loaded_ = false;
+            metaDirty_ = false;
+            migrated_ = false;
+        }
+
+        /**
+         * @brief Delete up to limit entries of an index that is no longer used, resuming at cursor.
+         * Every key is passed to del before its page is deleted.
+         *
+         * @param prefix Key prefix of the index
+         * @param cursor Position, updated
+         * @param limit Maximum number of entries deleted
+         * @param batch Batch of the deletes
+         * @param del Called with every key
+         * @return size_t Number of keys and pages deleted
+         */
+        template <typename Fn>
+        static size_t sweep(const std::string &prefix, uint64_t &cursor, size_t limit, StateBatch &batch, Fn del) {
+            Meta meta;
+            platon::getState(metaKey(prefix), meta);
+            size_t removed = 0;
+            uint64_t id = cursor >> 16;
+            size_t pos = cursor & 0xffff;
+            if (id == 0) {
+                id = 1;
+            }
+            for (; id < meta.nextId && removed < limit; ++id, pos = 0) {
+                Node n;
+                std::string key = nodeKey(prefix, id);
+                if (platon::getState(key, n) == 0) {
+                    continue;
+                }
+                for (; n.leaf && pos < n.keys.size() && removed < limit; ++pos, ++removed) {
+                    del(n.keys[pos]);
+                }
+                if (removed == limit) {
+                    break;
+                }
+                batch.del(key);
+                ++removed;
+            }
+            cursor = (id << 16) | pos;
+            if (id >= meta.nextId) {
+                batch.del(metaKey(prefix));
+                cursor = 0;
+            }
+            return removed;
+        }
+
+        /**
+         * @brief Whether an index in this format exists under the prefix
+         *
+         * @param prefix Key prefix
+         * @return true
+         * @return false
+         */
+        static bool stored(const std::string &prefix) {
+            return hasState(metaKey(prefix));
+        }
+
+    private:
+        static std::string metaKey(const std::string &prefix) {
+            return prefix + "#btree";
+        }
+
+        static std::string nodeKey(const std::string &prefix, uint64_t id) {
+            std::string key;
+            key.reserve(prefix.length() + 5 + sizeof(id));
+            key.append(prefix);
+            key.append("#node");
+            key.append((char*)&id, sizeof(id));
+            return key;
+        }
+
+        /**
+         * @brief Node of the id, read from the blockchain on first use
+         *
+         */
+        Node& node(uint64_t id) {
+            auto iter = nodes_.find(id);
+            if (iter != nodes_.end()) {
+                return iter->second;
+            }
+            Node &n = nodes_[id];
+            if (platon::getState(nodeKey(prefix_, id), n) == 0) {
+                platonThrow("key index page missing", prefix_, "id:", id);
+            }
+            return n;
+        }
+
+        uint64_t create(bool leaf) {
+            uint64_t id = meta_.nextId++;
+            nodes_[id].leaf = leaf;
+            dirty_.insert(id);
+            metaDirty_ = true;
+            return id;
+        }
+
+        void remove(uint64_t id) {
+            nodes_.erase(id);
+            dirty_.erase(id);
+            removed_.insert(id);
+        }
+
+        /**
+         * @brief Insert below a node
+         *
+         * @param id Node
+         * @param k Key
+         * @param split Separator of the new right sibling
+         * @param right New right sibling when the node was split, otherwise 0
+         * @return true The key is new
+         * @return false
+         */
+        bool insertInto(uint64_t id, const Key &k, Key &split, uint64_t &right) {
+            right = 0;
+            if (node(id).leaf) {
+                Node &n = node(id);
+                auto iter = std::lower_bound(n.keys.begin(), n.keys.end(), k);
+                if (iter != n.keys.end() && !(k < *iter)) {
+                    return false;
+                }
+                n.keys.insert(iter, k);
+                dirty_.insert(id);
+                if (n.keys.size() > PageSize) {
+                    right = create(true);
+                    Node &r = node(right);
+                    size_t mid = n.keys.size() / 2;
+                    r.keys.assign(n.keys.begin() + mid, n.keys.end());
+                    n.keys.resize(mid);
+                    r.prev = id;
+                    r.next = n.next;
+                    if (n.next != 0) {
+                        node(n.next).prev = right;
+                        dirty_.insert(n.next);
+                    } else {
+                        meta_.last = right;
+                    }
+                    n.next = right;
+                    split = r.keys[0];
+                }
+                return true;
+            }
+
+            size_t i = std::upper_bound(node(id).keys.begin(), node(id).keys.end(), k) - node(id).keys.begin();
+            Key childSplit;
+            uint64_t childRight = 0;
+            if (!insertInto(node(id).children[i], k, childSplit, childRight)) {
+                return false;
+            }
+            if (childRight == 0) {
+                return true;
+            }
+            Node &n = node(id);
+            n.keys.insert(n.keys.begin() + i, childSplit);
+            n.children.insert(n.children.begin() + i + 1, childRight);
+            dirty_.insert(id);
+            if (n.children.size() > PageSize) {
+                right = create(false);
+                Node &r = node(right);
+                size_t mid = n.keys.size() / 2;
+                split = n.keys[mid];
+                r.keys.assign(n.keys.begin() + mid + 1, n.keys.end());
+                r.children.assign(n.children.begin() + mid + 1, n.children.end());
+                n.keys.resize(mid);
+                n.children.resize(mid + 1);
+            }
+            return true;
+        }
+
+        /**
+         * @brief Erase below a node
+         *
+         * @param id Node
+         * @param k Key
+         * @param emptied Set when the node has no keys left and was unlinked
+         * @return true The key was found
+         * @return false
+         */
+        bool eraseFrom(uint64_t id, const Key &k, bool &emptied) {
+            emptied = false;
+            if (node(id).leaf) {
+                Node &n = node(id);
+                auto iter = std::lower_bound(n.keys.begin(), n.keys.end(), k);
+                if (iter == n.keys.end() || k < *iter) {
+                    return false;
+                }
+                n.keys.erase(iter);
+                dirty_.insert(id);
+                if (n.keys.empty()) {
+                    if (n.prev != 0) {
+                        node(n.prev).next = n.next;
+                        dirty_.insert(n.prev);
+                    } else {
+                        meta_.first = n.next;
+                    }
+                    if (n.next != 0) {
+                        node(n.next).prev = n.prev;
+                        dirty_.insert(n.next);
+                    } else {
+                        meta_.last = n.prev;
+                    }
+                    remove(id);
+                    emptied = true;
+                }
+                return true;
+            }
+
+            size_t i = std::upper_bound(node(id).keys.begin(), node(id).keys.end(), k) - node(id).keys.begin();
+            bool childEmptied = false;
+            if (!eraseFrom(node(id).children[i], k, childEmptied)) {
+                return false;
+            }
+            if (!childEmptied) {
+                return true;
+            }
+            Node &n = node(id);
+            n.children.erase(n.children.begin() + i);
+            if (!n.keys.empty()) {
+                n.keys.erase(n.keys.begin() + (i > 0 ? i - 1 : 0));
+            }
+            dirty_.insert(id);
+            if (n.children.empty()) {
+                if (id != meta_.root) {
+                    remove(id);
+                }
+                emptied = true;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Build the tree bottom up from the keys of the old format
+         *
+         * @param keys Sorted keys
+         */
+        void migrate(const std::set<Key> &keys) {
+            std::vector<uint64_t> level;
+            std::vector<Key> firstKeys;
+            uint64_t prev = 0;
+            for (auto iter = keys.begin(); iter != keys.end();) {
+                uint64_t id = create(true);
+                Node &n = node(id);
+                for (size_t i = 0; i < PageSize && iter != keys.end(); ++i, ++iter) {
+                    n.keys.push_back(*iter);
+                }
+                n.prev = prev;
+                if (prev != 0) {
+                    node(prev).next = id;
+                } else {
+                    meta_.first = id;
+                }
+                prev = id;
+                level.push_back(id);
+                firstKeys.push_back(n.keys[0]);
+            }
+            meta_.last = prev;
+            while (level.size() > 1) {
+                std::vector<uint64_t> upper;
+                std::vector<Key> upperKeys;
+                for (size_t i = 0; i < level.size(); i += PageSize) {
+                    uint64_t id = create(false);
+                    Node &n = node(id);
+                    for (size_t j = i; j < level.size() && j < i + PageSize; ++j) {
+                        if (j != i) {
+                            n.keys.push_back(firstKeys[j]);
+                        }
+                        n.children.push_back(level[j]);
+                    }
+                    upper.push_back(id);
+                    upperKeys.push_back(firstKeys[i]);
+                }
+                level.swap(upper);
+                firstKeys.swap(upperKeys);
+            }
+            meta_.root = level.empty() ? 0 : level[0];
+            meta_.size = keys.size();
+            metaDirty_ = true;
+            migrated_ = true;
+        }
+
+        const std::string &prefix_;
+        Meta meta_;
+        std::map<uint64_t, Node> nodes_;
+        std::set<uint64_t> dirty_;
+        std::set<uint64_t> removed_;
+        bool loaded_ = false;
+        bool metaDirty_ = false;
+        bool migrated_ = false;
+    };
+}
+}
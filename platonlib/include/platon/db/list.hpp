@@ -3,19 +3,39 @@
 //
 
 #pragma once
+#include <algorithm>
+#include <tuple>
+#include <vector>
 #include "platon/assert.h"
 #include "platon/storage.hpp"
+#include "platon/db/generation.hpp"
+#include "platon/db/cachetable.hpp"
+#include "platon/db/rankindex.hpp"
 
 
 namespace platon {
     namespace db {
+    /**
+     * @brief None keeps no index of the values, Value keeps a hashed index from values to positions in the state
+     *
+     */
+    enum class ListIndex {
+        None = 0,
+        Value = 1
+    };
+
     /**
      * @brief Implementation list function
      * 
      * @tparam *Name List name, list name is guaranteed to be unique in the same contract
      * @tparam Key List element type
+     * @tparam ListIndex::None The default is None, contains(), indexOf() and del() by value read every element.
+     * Set to Value to store the positions of every value under the digest of its serialized form, they then read
+     * one index key. Pushes, writes and deletes also write the index keys of the values they change. A list that
+     * already holds elements when the index is enabled has to index them with buildIndex() first, until then
+     * contains(), indexOf() and del() by value fail.
      */
-    template <const char *Name, typename Key>
+    template <const char *Name, typename Key, ListIndex valueIndex = ListIndex::None>
     class List {
     private:
         /**
@@ -42,6 +62,11 @@ namespace platon {
 
             }
 
+            Item(Key &&key, State state)
+                :key_(std::move(key)), state_(state) {
+
+            }
+
             /**
              * @brief Set the State object
              * 
@@ -78,20 +103,60 @@ namespace platon {
                 return key_;
             }
 
+            /**
+             * @brief Keep the serialized value read from the blockchain
+             *
+             */
+            void snapshot() {
+                snapshot_ = encodeState(key_);
+            }
+
+            /**
+             * @brief Whether the value differs from the one read from the blockchain
+             *
+             * @return true
+             * @return false
+             */
+            bool changed() const {
+                return encodeState(key_) != snapshot_;
+            }
+
+            /**
+             * @brief Serialized value read from the blockchain, empty for a pushed element
+             *
+             */
+            const std::string& stored() const {
+                return snapshot_;
+            }
+
+            /**
+             * @brief Serialized value the value index holds for the element, empty if none
+             *
+             */
+            std::string& indexed() {
+                return indexed_;
+            }
+
         private:
-            Key key_;
-            State state_;
+            Key key_ = Key();
+            State state_ = DEL;
+            std::string snapshot_;
+            std::string indexed_;
         };
 
+        typedef typename CacheTable<size_t, Item>::Entry Entry;
+
     public:
         /**
-         * @brief Iterator
+         * @brief Iterator. Dereferencing an element that is not cached reads the next
+         * kIteratorBatch elements in the direction of the last move into the cache with one
+         * getStates.
          * 
          */
         class Iterator : public std::iterator<std::bidirectional_iterator_tag, Key>{
         public:
             friend bool operator == ( const Iterator& a, const Iterator& b ) {
-                return a.list_ == b.list_ && a.pos_ = b.pos_;
+                return a.list_ == b.list_ && a.pos_ == b.pos_;
             }
             friend bool operator != ( const Iterator& a, const Iterator& b ) {
                 return a.list_ != b.list_ || a.pos_ != b.pos_;
@@ -103,7 +168,7 @@ namespace platon {
              * @param list List
              * @param pos starting point
              */
-            Iterator(List<Name, Key> *list, size_t pos)
+            Iterator(List<Name, Key, valueIndex> *list, size_t pos)
                     :list_(list), pos_(pos){
             }
 
@@ -113,7 +178,7 @@ namespace platon {
              * @return Key& 
              */
             Key& operator*() const {
-                return list_->get(pos_-1);
+                return list_->fetch(pos_-1, forward_);
             }
 
             /**
@@ -122,45 +187,49 @@ namespace platon {
              * @return Key& 
              */
             Key& operator->() const {
-                return list_->get(pos_-1);
+                return list_->fetch(pos_-1, forward_);
             }
 
             Iterator& operator--(){
                 pos_--;
+                forward_ = false;
                 return *this;
             }
 
             Iterator operator --(int) {
                 PlatonAssert(pos_ > 0, "pos can't be negative");
                 Iterator tmp(list_, pos_--);
-                --tmp;
                 return tmp;
             }
 
             Iterator& operator ++() {
                 pos_++;
+                forward_ = true;
                 return *this;
             }
 
             Iterator operator ++(int) {
                 Iterator tmp(list_, pos_++);
-                ++tmp;
                 return tmp;
             }
         private:
 
-            List<Name, Key> *list_;
+            List<Name, Key, valueIndex> *list_;
             size_t pos_;
+            bool forward_ = true;
         };
 
         /**
-         * @brief Constant iterator
+         * @brief Constant iterator. Elements are read in windows of kIteratorBatch elements
+         * with one getStates, without caching them; a window shows the list as it was read.
+         * Copies of an iterator share the window, so the references returned by a
+         * std::reverse_iterator stay valid.
          * 
          */
         class ConstIterator : public std::iterator<std::bidirectional_iterator_tag, Key>{
         public:
             friend bool operator == ( const ConstIterator &a, const ConstIterator &b ) {
-                return a.list_ == b.list_ && a.pos_ = b.pos_;
+                return a.list_ == b.list_ && a.pos_ == b.pos_;
             }
             friend bool operator != ( const ConstIterator &a, const ConstIterator &b ) {
                 return a.list_ != b.list_ || a.pos_ != b.pos_;
@@ -172,8 +241,8 @@ namespace platon {
              * @param list List
              * @param pos starting point
              */
-            ConstIterator(List<Name, Key> *list, size_t pos)
-                    :list_(list), pos_(pos){
+            ConstIterator(List<Name, Key, valueIndex> *list, size_t pos)
+                    :list_(list), pos_(pos), window_(std::make_shared<Window>()){
             }
 
             /**
@@ -182,8 +251,7 @@ namespace platon {
              * @return Key& 
              */
             Key& operator*() {
-                key_ = list_->getConst(pos_ -1);
-                return key_;
+                return value();
             }
 
             /**
@@ -192,59 +260,218 @@ namespace platon {
              * @return Key& 
              */
             Key& operator->() {
-                key_ = list_->getConst(pos_ -1);
-                return key_;
+                return value();
             }
 
             ConstIterator& operator--(){
                 pos_--;
+                forward_ = false;
                 return *this;
             }
 
             ConstIterator operator --(int) {
                 PlatonAssert(pos_ > 0, "pos can't be negative");
                 ConstIterator tmp(list_, pos_--);
-                --tmp;
                 return tmp;
             }
 
             ConstIterator& operator ++() {
                 pos_++;
+                forward_ = true;
                 return *this;
             }
 
             ConstIterator operator ++(int) {
                 ConstIterator tmp(list_, pos_++);
-                ++tmp;
                 return tmp;
             }
         private:
 
-            List<Name, Key> *list_;
+            /**
+             * @brief Elements read by the last fetch
+             *
+             */
+            struct Window {
+                size_t first = 0;
+                std::vector<Key> values;
+            };
+
+            Key& value() {
+                size_t index = pos_ - 1;
+                Window &w = *window_;
+                if (index < w.first || index >= w.first + w.values.size()) {
+                    w.first = list_->window(index, forward_, kIteratorBatch, w.values);
+                }
+                return w.values[index - w.first];
+            }
+
+            List<Name, Key, valueIndex> *list_;
             size_t pos_;
-            Key key_;
+            bool forward_ = true;
+            std::shared_ptr<Window> window_;
         };
         typedef std::reverse_iterator<Iterator> ReverseIterator;
         typedef std::reverse_iterator<ConstIterator> ConstReverseIterator;
+
+        /**
+         * @brief Read-only cursor over the elements in order or in reverse. It walks the mark once
+         * and reads the next batch of live elements with one getStates, cached elements are taken
+         * from the cache. A forward cursor also visits the elements pushed while it walks; deleting
+         * or compacting elements invalidates it.
+         *
+         * Example:
+         * @code
+         * for (const std::string &v : list.scan()) {
+         *     ...
+         * }
+         * @endcode
+         */
+        class Cursor {
+        public:
+            /**
+             * @brief Input iterator of a cursor for range-for, the end iterator has no cursor
+             *
+             */
+            class iterator {
+            public:
+                explicit iterator(Cursor *cursor)
+                    :cursor_(cursor != nullptr && cursor->valid() ? cursor : nullptr) {}
+
+                const Key& operator*() const { return cursor_->value(); }
+                const Key* operator->() const { return &cursor_->value(); }
+
+                iterator& operator++() {
+                    cursor_->next();
+                    if (!cursor_->valid()) {
+                        cursor_ = nullptr;
+                    }
+                    return *this;
+                }
+
+                bool operator==(const iterator &other) const { return cursor_ == other.cursor_; }
+                bool operator!=(const iterator &other) const { return cursor_ != other.cursor_; }
+            private:
+                Cursor *cursor_;
+            };
+
+            /**
+             * @brief Construct a new Cursor object
+             *
+             * @param list List
+             * @param pos Mark position to start from, a reverse cursor starts before it
+             * @param forward Whether the cursor walks towards the tail
+             * @param batch Number of elements read per host call
+             */
+            Cursor(List *list, size_t pos, bool forward, size_t batch)
+                :list_(list), next_(pos), forward_(forward), batch_(batch == 0 ? 1 : batch) {
+                fetch();
+            }
+
+            /**
+             * @brief Whether the cursor is on an element
+             *
+             * @return true
+             * @return false
+             */
+            bool valid() const {
+                return pos_ < values_.size();
+            }
+
+            const Key& value() const {
+                return values_[pos_];
+            }
+
+            /**
+             * @brief Index of the element in the list
+             *
+             * @return size_t
+             */
+            size_t index() const {
+                return list_->rank_.rank(positions_[pos_]);
+            }
+
+            /**
+             * @brief Move to the next element, reads the next batch when needed
+             *
+             */
+            void next() {
+                if (++pos_ >= values_.size()) {
+                    fetch();
+                }
+            }
+
+            iterator begin() { return iterator(this); }
+            iterator end() { return iterator(nullptr); }
+        private:
+            void fetch() {
+                positions_.clear();
+                values_.clear();
+                pos_ = 0;
+                const std::vector<bool> &mark = list_->mark_;
+                std::vector<std::string> keys;
+                std::vector<size_t> slots;
+                while (values_.size() < batch_) {
+                    size_t i = 0;
+                    if (forward_) {
+                        if (next_ >= mark.size()) {
+                            break;
+                        }
+                        i = next_++;
+                    } else {
+                        if (next_ == 0) {
+                            break;
+                        }
+                        i = --next_;
+                    }
+                    if (!mark[i]) {
+                        continue;
+                    }
+                    positions_.push_back(i);
+                    values_.push_back(Key());
+                    Entry *cached = list_->cache_.find(i);
+                    if (cached != nullptr) {
+                        values_.back() = cached->value.getKey();
+                    } else {
+                        keys.push_back(list_->encodeKey(i));
+                        slots.push_back(values_.size() - 1);
+                    }
+                }
+                if (keys.empty()) {
+                    return;
+                }
+                std::vector<Key> values;
+                platon::getStates(keys, values);
+                for (size_t j = 0; j < slots.size(); ++j) {
+                    values_[slots[j]] = std::move(values[j]);
+                }
+            }
+
+            List *list_;
+            size_t next_;                   // mark position walked next, one past it in reverse
+            bool forward_;
+            size_t batch_;
+            std::vector<size_t> positions_;
+            std::vector<Key> values_;
+            size_t pos_ = 0;
+        };
     public:
         /**
          * @brief Construct a new List object
          * 
          */
         List(){
-            init();
         }
 
-        List(const List<Name, Key> &) = delete;
-        List(const List<Name, Key> &&) = delete;
-        List<Name, Key>& operator=(const List<Name, Key> &) = delete;
+        List(const List<Name, Key, valueIndex> &) = delete;
+        List(const List<Name, Key, valueIndex> &&) = delete;
+        List<Name, Key, valueIndex>& operator=(const List<Name, Key, valueIndex> &) = delete;
 
         /**
-         * @brief Destroy the List object. Refresh into the blockchain
+         * @brief Destroy the List object. The list is shared by the objects of the same name
+         * in the call and refreshed to blockchain once, see sharedState().
          * 
          */
         ~List(){
-            flush();
         }
 
         /**
@@ -318,17 +545,60 @@ namespace platon {
             return make_reverse_iterator(cbegin());
         }
 
+        /**
+         * @brief Read-only cursor from the first element to the last
+         *
+         * @param batch Number of elements read per host call
+         * @return Cursor
+         */
+        Cursor scan(size_t batch = 64) {
+            return Cursor(this, 0, true, batch);
+        }
+
+        /**
+         * @brief Read-only cursor from the last element to the first
+         *
+         * @param batch Number of elements read per host call
+         * @return Cursor
+         */
+        Cursor rscan(size_t batch = 64) {
+            return Cursor(this, mark_.size(), false, batch);
+        }
+
         /**
          * @brief Add element
          * 
          * @param k element
          */
         void push(const Key &k){
-            cache_[maxNumber_++] = Item(k, MOD);
+            item(maxNumber_++) = Item(k, MOD);
+            mark_.push_back(true);
+            rank_.push(true);
+            ++size_;
+        }
+
+        /**
+         * @brief Add element, moved into the cache
+         *
+         * @param k element
+         */
+        void push(Key &&k){
+            item(maxNumber_++) = Item(std::move(k), MOD);
             mark_.push_back(true);
+            rank_.push(true);
             ++size_;
         }
 
+        /**
+         * @brief Add element constructed from args
+         *
+         * @param args Arguments of a Key constructor
+         */
+        template <typename... Args>
+        void emplace(Args&&... args){
+            push(Key(std::forward<Args>(args)...));
+        }
+
         /**
          * @brief Get the specified position element
          * 
@@ -339,34 +609,26 @@ namespace platon {
             PlatonAssert(index < size_, "out of range", "index:", index, "size:", size_);
 
 
-            size_t count = 0;
-            size_t i = 0;
-            for (; i < mark_.size(); ++i) {
-                if (count == index && mark_[i]) {
-                    break;
-                }
-
-                if (mark_[i]) {
-                    count++;
-                }
-            }
-
-            PlatonAssert(i != mark_.size());
+            size_t i = position(index);
 
-            auto iter = cache_.find(i);
-            if (iter != cache_.end()) {
-                return iter->second.getKey();
+            Entry *e = cache_.find(i);
+            if (e != nullptr) {
+                return e->value.getKey();
             }
 
-            Key res;
+            Item &cached = item(i);
+            cached.setState(NORMAL);
             std::string key = encodeKey(i);
-            if (getState(key, res) == 0) {
+            if (getState(key, cached.getKey()) == 0) {
+                cache_.erase(i);
                 platonThrow("getState error list name:", name_, "index:", index, "mark pos;", i);
             }
-            auto iterc = cache_.emplace(std::make_pair(count, Item(res, MOD)));
-
+            cached.snapshot();
+            if (valueIndex == ListIndex::Value) {
+                cached.indexed() = cached.stored();
+            }
 
-            return iterc.first->second.getKey();
+            return cached.getKey();
         }
 
         /**
@@ -376,50 +638,54 @@ namespace platon {
          */
         void del(size_t index) {
             PlatonAssert(index < size_, "out of range index:", index, "size:", size_);
-            auto iter = cache_.find(index);
-            if (iter != cache_.end()) {
-                --size_;
-                return iter->second.setState(DEL);
-            }
-            size_t count = 0;
-            size_t i = 0;
-            for (; i < mark_.size(); ++i) {
-                if (count == index && mark_[i]) {
-                    break;
-                }
-                if (mark_[i]) {
-                    count++;
-                }
-            }
-            if (i != mark_.size()) {
-                Key res;
-                std::string key = encodeKey(count);
-                platon::delState(key);
-                mark_[i] = false;
-                --size_;
-            }
+            erase(position(index), nullptr);
         }
 
         /**
-         * @brief Delete the element of the specified value
+         * @brief Delete every element of the specified value
          * 
          * @param delKey Specified element value
          */
         void del(const Key &delKey) {
+            if (valueIndex == ListIndex::Value) {
+                PlatonAssert(core_->indexBuilt(), "value index of list is not built", name_);
+                std::string bytes = encodeState(delKey);
+                core_->syncValues();
+                std::vector<uint64_t> positions = core_->slots(bytes).positions;
+                for (uint64_t i : positions) {
+                    erase(i, &bytes);
+                }
+                return;
+            }
             for (size_t i = 0; i < mark_.size(); ++i) {
-                if (mark_[i]) {
-                    Key res;
-                    std::string key = encodeKey(i);
-                    getState(key, res);
-                    if (res == delKey) {
-                        cache_.erase(i);
-                        platon::delState(key);
-                        --size_;
-                    }
+                if (mark_[i] && read(i) == delKey) {
+                    erase(i, nullptr);
                 }
             }
         }
 
+        /**
+         * @brief Whether an element has the specified value
+         *
+         * @param k Element value
+         * @return true
+         * @return false
+         */
+        bool contains(const Key &k) {
+            return find(k) < mark_.size();
+        }
+
+        /**
+         * @brief Index of the first element of the specified value
+         *
+         * @param k Element value
+         * @return size_t size() if no element has the value
+         */
+        size_t indexOf(const Key &k) {
+            size_t i = find(k);
+            return i < mark_.size() ? rank_.rank(i) : size_;
+        }
+
         /**
          * @brief Bracket operator
          * 
@@ -441,26 +707,14 @@ namespace platon {
             PlatonAssert(index < size_, "out of range", "index:", index, "size:", size_);
 
 
-            size_t count = 0;
-            size_t i = 0;
-            for (; i < mark_.size(); ++i) {
-                if (count == index && mark_[i]) {
-                    break;
-                }
-
-                if (mark_[i]) {
-                    count++;
-                }
-            }
+            size_t i = position(index);
 
-            PlatonAssert(i != mark_.size());
-
-            auto iter = cache_.find(i);
-            if (iter != cache_.end()) {
-                return iter->second.getKey();
+            Entry *e = cache_.find(i);
+            if (e != nullptr) {
+                return e->value.getKey();
             }
 
-            Key res;
+            Key res = Key();
             std::string key = encodeKey(i);
             if (getState(key, res) == 0) {
                 platonThrow("getState error list name:", name_, "index:", index, "mark pos;", i);
@@ -478,25 +732,20 @@ namespace platon {
             PlatonAssert(index < size_, "out of range", "index:", index, "size:", size_);
 
 
-            size_t count = 0;
-            size_t i = 0;
-            for (; i < mark_.size(); ++i) {
-                if (count == index && mark_[i]) {
-                    break;
-                }
+            size_t i = position(index);
 
-                if (mark_[i]) {
-                    count++;
+            if (valueIndex == ListIndex::Value) {
+                Entry *e = cache_.find(i);
+                if (e != nullptr) {
+                    core_->indexValue(e->value.indexed(), i, false);
+                } else {
+                    core_->indexValue(encodeState(read(i)), i, false);
                 }
+                core_->indexValue(encodeState(key), i, true);
             }
-
-            PlatonAssert(i != mark_.size());
-
             std::string skey = encodeKey(i);
             setState(skey, key);
-            if (cache_.find(i) != cache_.end()) {
-                cache_.erase(i);
-            }
+            cache_.erase(i);
         }
 
         /**
@@ -508,84 +757,370 @@ namespace platon {
             return size_;
         }
 
+        /**
+         * @brief Bound the element cache. Caching an element in a full cache writes back and
+         * evicts cold elements, so long batch jobs run in bounded memory. A reference returned
+         * by get() may be invalidated by the second element cached after it.
+         *
+         * @param entries Maximum number of cached elements, 0 is unbounded
+         */
+        void setCacheLimit(size_t entries) {
+            cache_.setLimit(entries);
+        }
+
+        /**
+         * @brief Move up to limit elements into the positions of deleted ones, keeping their
+         * order, and shrink the mark when its tail is deleted. Every call leaves a valid list,
+         * so a long compaction can be spread over calls. Cached elements are written first and
+         * references to them become invalid.
+         *
+         * The flush at the end of the call runs a compaction of kCompactMoves elements when
+         * more than half of at least kCompactHoles positions are deleted.
+         *
+         * @param limit Maximum number of elements moved
+         * @return size_t Number of elements moved, 0 when the list is compact
+         */
+        size_t compact(size_t limit) {
+            return core_->compact(limit);
+        }
 
+        /**
+         * @brief Add up to limit positions of the elements that were pushed before the value
+         * index was enabled to the index. Every call leaves a valid list, so a long build can
+         * be spread over calls; lookups by value work once it returns 0.
+         *
+         * @param limit Maximum number of positions indexed
+         * @return size_t Number of positions indexed, 0 when the index is complete
+         */
+        size_t buildIndex(size_t limit) {
+            static_assert(valueIndex == ListIndex::Value, "list has no value index");
+            std::vector<size_t> positions;
+            std::vector<std::string> keys;
+            size_t walked = 0;
+            for (; walked < limit && core_->indexCursor < core_->indexEnd; ++walked) {
+                size_t i = core_->indexCursor++;
+                if (!mark_[i]) {
+                    continue;
+                }
+                Entry *e = cache_.find(i);
+                if (e != nullptr) {
+                    // the cache assumes the stored value is indexed, later changes are synced
+                    core_->indexValue(e->value.indexed(), i, true);
+                } else {
+                    positions.push_back(i);
+                    keys.push_back(encodeState(encodeKey(i)));
+                }
+            }
+            std::vector<std::string> values;
+            platon::getStatesBytes(keys, values);
+            for (size_t j = 0; j < positions.size(); ++j) {
+                core_->indexValue(values[j], positions[j], true);
+            }
+            core_->indexDirty = core_->indexDirty || walked != 0;
+            return walked;
+        }
+
+        /**
+         * @brief Whether every element is in the value index, see buildIndex()
+         *
+         * @return true
+         * @return false
+         */
+        bool indexBuilt() {
+            return core_->indexBuilt();
+        }
+
+
+
+        /**
+         * @brief Remove all elements with a constant number of writes. The old elements
+         * become unreachable, sweep() deletes them from the blockchain.
+         *
+         */
+        void clear() {
+            // sweep() reads the length of the old generation, elements spilled in this call
+            // may lie past the stored one. It deletes the value index keys of the stored
+            // elements, so their pending changes are written first.
+            if (valueIndex == ListIndex::Value) {
+                core_->flush();
+            } else {
+                StateBatch batch;
+                batch.set(generation().key(0), maxNumber_);
+                batch.commit();
+            }
+            generation().next();
+            cache_.clear();
+            mark_.clear();
+            rank_.clear();
+            core_->values.clear();
+            core_->indexCursor = 0;
+            core_->indexEnd = 0;
+            core_->indexDirty = valueIndex == ListIndex::Value;
+            maxNumber_ = 0;
+            size_ = 0;
+        }
+
+        /**
+         * @brief Delete up to limit elements left behind by clear(). A list with a value index
+         * reads the elements to delete their index keys as well.
+         *
+         * @param limit Maximum number of elements deleted
+         * @return size_t Number of elements deleted, 0 when nothing is left
+         */
+        size_t sweep(size_t limit) {
+            Generation &gen = generation();
+            if (!gen.pending()) {
+                return 0;
+            }
+            StateBatch batch;
+            size_t removed = 0;
+            while (gen.pending() && removed < limit) {
+                std::string name = gen.prefix(gen.swept());
+                std::string maxNumberKey = gen.key(gen.swept(), 0);
+                size_t maxNumber = 0;
+                getState(maxNumberKey, maxNumber);
+                std::vector<std::string> keys;
+                for (; gen.cursor() < maxNumber && removed < limit; ++removed) {
+                    std::string key = encodeKey(name, gen.cursor());
+                    if (valueIndex == ListIndex::Value) {
+                        keys.push_back(encodeState(key));
+                    }
+                    batch.del(key);
+                    gen.step(1);
+                }
+                std::vector<std::string> values;
+                platon::getStatesBytes(keys, values);
+                for (const std::string &bytes : values) {
+                    if (!bytes.empty()) {
+                        batch.del(Core::valueKey(name, bytes));
+                    }
+                }
+                if (gen.cursor() >= maxNumber) {
+                    batch.del(name);
+                    batch.del(maxNumberKey);
+                    batch.del(gen.key(gen.swept(), 1));
+                    batch.del(gen.key(gen.swept(), 2));
+                    gen.advance();
+                }
+            }
+            batch.commit();
+            gen.save();
+            return removed;
+        }
 
     private:
         /**
-         * @brief 初始化
-         * 
+         * @brief Value of a live element, cached or read
+         *
+         * @param i Mark position
+         * @return Key
+         */
+        Key read(size_t i) {
+            Entry *e = cache_.find(i);
+            if (e != nullptr) {
+                return e->value.getKey();
+            }
+            Key res = Key();
+            if (getState(encodeKey(i), res) == 0) {
+                platonThrow("getState error list name:", name_, "mark pos;", i);
+            }
+            return res;
+        }
+
+        /**
+         * @brief Element at an index for an iterator, a miss first reads a batch of elements
+         * into the cache
+         *
+         * @param index Index among the live elements
+         * @param forward Whether the batch follows the index or ends at it
+         * @return Key&
          */
-        void init() {
-            getMaxNumber();
-            getSize();
-            getMark();
+        Key& fetch(size_t index, bool forward) {
+            PlatonAssert(index < size_, "out of range", "index:", index, "size:", size_);
+            if (cache_.find(position(index)) == nullptr) {
+                prefetch(index, forward, kIteratorBatch);
+            }
+            return get(index);
         }
 
         /**
-         * @brief Refresh data to blockchain
-         * 
+         * @brief First and end index of up to count elements after or up to an index
+         *
          */
-        void flush() {
-            for (auto it : cache_) {
-                if (it.second.getState() == DEL) {
-                    platon::delState(encodeKey(it.first));
-                    mark_[it.first] = false;
-                } else if (it.second.getState() == MOD) {
-                    std::string key = encodeKey(it.first);
-                    setState(key, it.second.getKey());
+        std::pair<size_t, size_t> span(size_t index, bool forward, size_t count) const {
+            size_t first = forward ? index : (index + 1 > count ? index + 1 - count : 0);
+            return std::make_pair(first, std::min(size_, first + count));
+        }
+
+        /**
+         * @brief Read the elements of a span that are not cached into the cache with one
+         * getStates. The span is cut to the room left in a bounded cache, so it evicts nothing.
+         *
+         * @param index Index among the live elements
+         * @param forward Whether the span follows the index or ends at it
+         * @param count Maximum number of elements
+         */
+        void prefetch(size_t index, bool forward, size_t count) {
+            if (cache_.limit() != 0) {
+                count = std::min(count, cache_.limit() > cache_.size() ? cache_.limit() - cache_.size() : 0);
+            }
+            if (count <= 1) {
+                return;
+            }
+            std::pair<size_t, size_t> range = span(index, forward, count);
+            std::vector<size_t> positions;
+            std::vector<std::string> keys;
+            for (size_t n = range.first, i = position(range.first); n < range.second; ++i) {
+                if (!mark_[i]) {
+                    continue;
+                }
+                if (cache_.find(i) == nullptr) {
+                    positions.push_back(i);
+                    keys.push_back(encodeKey(i));
+                }
+                ++n;
+            }
+            std::vector<Key> values;
+            if (platon::getStates(keys, values) != keys.size()) {
+                platonThrow("getState error list name:", name_, "index:", index);
+            }
+            for (size_t j = 0; j < positions.size(); ++j) {
+                Item &cached = cache_.get(positions[j]).value;
+                cached = Item(std::move(values[j]), NORMAL);
+                cached.snapshot();
+                if (valueIndex == ListIndex::Value) {
+                    cached.indexed() = cached.stored();
                 }
             }
-            setMark();
-            setMaxNumber();
-            setSize();
         }
 
         /**
-         * @brief Set the Mark object
-         * 
+         * @brief Values of up to count elements after or up to an index, cached elements are
+         * copied and the others read with one getStates
+         *
+         * @param index Index among the live elements
+         * @param forward Whether the window follows the index or ends at it
+         * @param count Maximum number of elements
+         * @param values Values of the window
+         * @return size_t Index of the first element of the window
          */
-        void setMark() {
-            setState(name_, mark_);
+        size_t window(size_t index, bool forward, size_t count, std::vector<Key> &values) {
+            PlatonAssert(index < size_, "out of range", "index:", index, "size:", size_);
+            std::pair<size_t, size_t> range = span(index, forward, count);
+            values.assign(range.second - range.first, Key());
+            std::vector<size_t> slots;
+            std::vector<std::string> keys;
+            for (size_t n = range.first, i = position(range.first); n < range.second; ++i) {
+                if (!mark_[i]) {
+                    continue;
+                }
+                Entry *cached = cache_.find(i);
+                if (cached != nullptr) {
+                    values[n - range.first] = cached->value.getKey();
+                } else {
+                    slots.push_back(n - range.first);
+                    keys.push_back(encodeKey(i));
+                }
+                ++n;
+            }
+            std::vector<Key> read;
+            if (platon::getStates(keys, read) != keys.size()) {
+                platonThrow("getState error list name:", name_, "index:", index);
+            }
+            for (size_t j = 0; j < slots.size(); ++j) {
+                values[slots[j]] = std::move(read[j]);
+            }
+            return range.first;
         }
 
         /**
-         * @brief Get the Mark object
-         * 
+         * @brief Delete a live element
+         *
+         * @param i Mark position
+         * @param stored Serialized value of the element if known, only needed by the value index
          */
-        void getMark() {
-            getState(name_, mark_);
+        void erase(size_t i, const std::string *stored) {
+            Entry *e = cache_.find(i);
+            if (e != nullptr) {
+                e->value.setState(DEL);
+                core_->syncValue(*e);
+            } else {
+                if (valueIndex == ListIndex::Value) {
+                    core_->indexValue(stored != nullptr ? *stored : encodeState(read(i)), i, false);
+                }
+                platon::delState(encodeKey(i));
+            }
+            core_->unmark(i);
+            --size_;
         }
 
         /**
-         * @brief Set the Max Number object
-         * 
+         * @brief Mark position of the first element of a value, mark_.size() if none
+         *
+         * @param k Element value
+         * @return size_t
+         */
+        size_t find(const Key &k) {
+            if (valueIndex == ListIndex::Value) {
+                PlatonAssert(core_->indexBuilt(), "value index of list is not built", name_);
+                core_->syncValues();
+                const std::vector<uint64_t> &positions = core_->slots(encodeState(k)).positions;
+                return positions.empty() ? mark_.size() : positions.front();
+            }
+            for (size_t i = 0; i < mark_.size(); ++i) {
+                if (mark_[i] && read(i) == k) {
+                    return i;
+                }
+            }
+            return mark_.size();
+        }
+
+        /**
+         * @brief Cached element at a mark position, cold elements are written back and
+         * evicted first when the cache is full
+         *
+         * @param i Mark position
+         * @return Item&
          */
-        void setMaxNumber(){
-            setState(maxNumberKey_, maxNumber_);
+        Item& item(size_t i) {
+            if (cache_.full() && cache_.find(i) == nullptr) {
+                core_->spill();
+            }
+            return cache_.get(i).value;
         }
 
         /**
-         * @brief Get the Max Number object
-         * 
+         * @brief Mark position of the element at an index, O(log n)
+         *
+         * @param index Index among the live elements
+         * @return size_t
          */
-        void getMaxNumber() {
-            getState(maxNumberKey_, maxNumber_);
+        size_t position(size_t index) {
+            size_t i = rank_.select(index);
+            PlatonAssert(i < mark_.size(), "list mark broken", name_, "index:", index);
+            return i;
         }
 
         /**
-         * @brief Set the Size object
-         * 
+         * @brief Key prefix of the list, also the key of the mark
+         *
+         * @return const std::string&
          */
-        void setSize(){
-            setState(sizeKey_, size_);
+        static const std::string& prefix() {
+            static const std::string prefix = statePrefix<Name>(kType, 'l');
+            return prefix;
         }
 
         /**
-         * @brief Get the Size object
-         * 
+         * @brief Generation of the list, its fixed keys are the maxNumber, size and value
+         * index build keys
+         *
+         * @return Generation&
          */
-        void getSize(){
-            getState(sizeKey_, size_);
+        static Generation& generation() {
+            static Generation gen(prefix(), {"maxNumber", "size", "valueIndex"});
+            gen.load();
+            return gen;
         }
 
         /**
@@ -594,26 +1129,376 @@ namespace platon {
          * @param index 
          * @return std::string 
          */
-        std::string encodeKey(size_t index) const {
+        static std::string encodeKey(size_t index) {
+            return encodeKey(generation().prefix(), index);
+        }
+
+        /**
+         * @brief Generate the key of the specified index in a generation
+         *
+         * @param name Key prefix of the generation
+         * @param index
+         * @return std::string
+         */
+        static std::string encodeKey(const std::string &name, size_t index) {
             std::string key;
-            key.reserve(name_.length() + 1 + sizeof(index));
-            key.append(name_);
+            key.reserve(name.length() + 1 + sizeof(index));
+            key.append(name);
             key.append(1, 'L');
             key.append((char*)&index, sizeof(index));
             return key;
         }
+
+        /**
+         * @brief Positions of one value in the value index
+         *
+         */
+        struct Slots {
+            std::vector<uint64_t> positions;    // sorted
+            bool dirty = false;
+        };
+
+        /**
+         * @brief Cache, mark and value index of the list, shared by the List objects of the call
+         *
+         */
+        struct Core {
+            Core() {
+                load();
+            }
+
+            ~Core() {
+                flush(true);
+            }
+
+            /**
+             * @brief Read the counters and the mark
+             *
+             */
+            void load() {
+                maxNumber = 0;
+                size = 0;
+                getState(generation().key(0), maxNumber);
+                getState(generation().key(1), size);
+                getState(generation().prefix(), mark);
+                rank.build(mark);
+                if (valueIndex == ListIndex::Value) {
+                    // without a record of the index, the stored elements were pushed before it
+                    std::tuple<uint64_t, uint64_t> build(0, 0);
+                    indexDirty = getState(generation().key(2), build) == 0;
+                    if (indexDirty) {
+                        build = std::make_tuple(0, maxNumber);
+                    }
+                    indexCursor = std::get<0>(build);
+                    indexEnd = std::get<1>(build);
+                }
+            }
+
+            /**
+             * @brief Whether the value index covers every element
+             *
+             */
+            bool indexBuilt() const {
+                return indexCursor >= indexEnd;
+            }
+
+            /**
+             * @brief Write the positions left to buildIndex() if they changed
+             *
+             * @param batch Batch of the flush
+             */
+            void flushBuild(StateBatch &batch) {
+                if (indexDirty) {
+                    batch.set(generation().key(2), std::make_tuple(indexCursor, indexEnd));
+                    indexDirty = false;
+                }
+            }
+
+            /**
+             * @brief Refresh data to blockchain, elements that were only read are skipped.
+             * The cache is kept, so references and iterators stay valid.
+             *
+             * @param compacting Whether a compaction step may run. It drops the cache, so only
+             * the flush at the end of the call runs it.
+             */
+            void flush(bool compacting = false) {
+                StateBatch batch;
+                std::vector<size_t> deleted;
+                for (Entry &e : cache) {
+                    if (e.value.getState() == DEL) {
+                        deleted.push_back(e.key);
+                    }
+                    write(batch, e);
+                }
+                for (size_t i : deleted) {
+                    cache.erase(i);
+                }
+                size_t holes = mark.size() - size;
+                if (compacting && holes >= kCompactHoles && holes > size) {
+                    // the moves read the elements, written ones have to reach the state first
+                    batch.commit();
+                    cache.clear();
+                    move(kCompactMoves, batch);
+                }
+                flushValues(batch);
+                flushBuild(batch);
+                batch.set(generation().prefix(), mark);
+                batch.set(generation().key(0), maxNumber);
+                batch.set(generation().key(1), size);
+                batch.commit();
+            }
+
+            /**
+             * @brief Drop the cached elements and value index entries without writing them,
+             * then read the counters and the mark again
+             *
+             */
+            void reload() {
+                cache.clear();
+                values.clear();
+                generation().reload();
+                load();
+            }
+
+            /**
+             * @brief Evict cold elements, changed ones are written first
+             *
+             */
+            void spill() {
+                StateBatch batch;
+                cache.shrink([&](Entry &e) { write(batch, e); });
+                batch.commit();
+            }
+
+            /**
+             * @brief See List::compact()
+             *
+             */
+            size_t compact(size_t limit) {
+                StateBatch batch;
+                for (Entry &e : cache) {
+                    write(batch, e);
+                }
+                batch.commit();
+                cache.clear();
+                size_t moved = move(limit, batch);
+                flushValues(batch);
+                flushBuild(batch);
+                batch.set(generation().prefix(), mark);
+                batch.set(generation().key(0), maxNumber);
+                batch.commit();
+                return moved;
+            }
+
+            /**
+             * @brief Add the change of a cached element to a batch. A written element becomes
+             * clean, deleted ones are dropped by the caller.
+             *
+             * @param batch Batch of the flush
+             * @param e Cached element
+             */
+            void write(StateBatch &batch, Entry &e) {
+                syncValue(e);
+                Item &it = e.value;
+                if (it.getState() == DEL) {
+                    batch.del(encodeKey(e.key));
+                    unmark(e.key);
+                } else if (it.getState() == MOD || (it.getState() == NORMAL && it.changed())) {
+                    batch.set(encodeKey(e.key), it.getKey());
+                    it.setState(NORMAL);
+                    it.snapshot();
+                }
+            }
+
+            /**
+             * @brief Move live elements into the first deleted positions, then drop the deleted
+             * tail. Nothing may be cached.
+             *
+             * @param limit Maximum number of elements moved
+             * @param batch Batch of the moves
+             * @return size_t Number of elements moved
+             */
+            size_t move(size_t limit, StateBatch &batch) {
+                size_t moved = 0;
+                // positions before the first hole are all live, the live element after it has rank hole
+                for (size_t hole = rank.selectHole(0); moved < limit && hole < size; hole = rank.selectHole(0)) {
+                    size_t from = rank.select(hole);
+                    Key key = Key();
+                    if (getState(encodeKey(from), key) == 0) {
+                        platonThrow("getState error list name:", generation().prefix(), "mark pos;", from);
+                    }
+                    batch.set(encodeKey(hole), key);
+                    batch.del(encodeKey(from));
+                    if (valueIndex == ListIndex::Value) {
+                        std::string bytes = encodeState(key);
+                        indexValue(bytes, from, false);
+                        indexValue(bytes, hole, true);
+                    }
+                    mark[hole] = true;
+                    rank.add(hole, 1);
+                    unmark(from);
+                    ++moved;
+                }
+                size_t length = size == 0 ? 0 : rank.select(size - 1) + 1;
+                if (length < mark.size()) {
+                    mark.resize(length);
+                    rank.truncate(length);
+                    maxNumber = length;
+                    if (indexEnd > length) {
+                        indexEnd = length;
+                        indexCursor = std::min(indexCursor, indexEnd);
+                        indexDirty = true;
+                    }
+                }
+                return moved;
+            }
+
+            /**
+             * @brief Mark a position deleted
+             *
+             * @param i Mark position
+             */
+            void unmark(size_t i) {
+                if (mark[i]) {
+                    mark[i] = false;
+                    rank.add(i, -1);
+                }
+            }
+
+            /**
+             * @brief Key of the positions of a serialized value
+             *
+             * @param bytes Serialized value
+             * @return std::string
+             */
+            static std::string valueKey(const std::string &bytes) {
+                return valueKey(generation().prefix(), bytes);
+            }
+
+            /**
+             * @brief Key of the positions of a serialized value in a generation
+             *
+             * @param name Key prefix of the generation
+             * @param bytes Serialized value
+             * @return std::string
+             */
+            static std::string valueKey(const std::string &name, const std::string &bytes) {
+                byte digest[32];
+                ::sha3((const byte*)bytes.data(), bytes.size(), digest, sizeof(digest));
+                std::string key;
+                key.reserve(name.length() + 1 + sizeof(digest));
+                key.append(name);
+                key.append(1, 'V');
+                key.append((const char*)digest, sizeof(digest));
+                return key;
+            }
+
+            /**
+             * @brief Positions of a serialized value, read once per call
+             *
+             */
+            Slots& slots(const std::string &bytes) {
+                std::string key = valueKey(bytes);
+                auto iter = values.find(key);
+                if (iter != values.end()) {
+                    return iter->second;
+                }
+                Slots &s = values[key];
+                getState(key, s.positions);
+                return s;
+            }
+
+            /**
+             * @brief Add or remove a position of a serialized value
+             *
+             * @param bytes Serialized value, nothing is done if empty
+             * @param i Mark position
+             * @param add true to add, false to remove
+             */
+            void indexValue(const std::string &bytes, size_t i, bool add) {
+                if (valueIndex != ListIndex::Value || bytes.empty()) {
+                    return;
+                }
+                Slots &s = slots(bytes);
+                auto iter = std::lower_bound(s.positions.begin(), s.positions.end(), (uint64_t)i);
+                bool found = iter != s.positions.end() && *iter == i;
+                if (add && !found) {
+                    s.positions.insert(iter, i);
+                    s.dirty = true;
+                } else if (!add && found) {
+                    s.positions.erase(iter);
+                    s.dirty = true;
+                }
+            }
+
+            /**
+             * @brief Bring the value index in line with a cached element, whose value may have
+             * been changed through a reference
+             *
+             */
+            void syncValue(Entry &e) {
+                if (valueIndex != ListIndex::Value) {
+                    return;
+                }
+                Item &it = e.value;
+                std::string bytes = it.getState() == DEL ? std::string() : encodeState(it.getKey());
+                if (bytes != it.indexed()) {
+                    indexValue(it.indexed(), e.key, false);
+                    indexValue(bytes, e.key, true);
+                    it.indexed() = std::move(bytes);
+                }
+            }
+
+            void syncValues() {
+                for (Entry &e : cache) {
+                    syncValue(e);
+                }
+            }
+
+            /**
+             * @brief Write the changed positions of the value index
+             *
+             * @param batch Batch of the flush
+             */
+            void flushValues(StateBatch &batch) {
+                for (auto &iter : values) {
+                    if (!iter.second.dirty) {
+                        continue;
+                    }
+                    if (iter.second.positions.empty()) {
+                        batch.del(iter.first);
+                    } else {
+                        batch.set(iter.first, iter.second.positions);
+                    }
+                    iter.second.dirty = false;
+                }
+            }
+
+            CacheTable<size_t, Item> cache;
+            std::vector<bool> mark;
+            RankIndex rank;                  // live positions of mark
+            std::map<std::string, Slots> values;     // value index entries read or changed in the call
+            size_t maxNumber = 0;
+            size_t size = 0;
+            uint64_t indexCursor = 0;        // next position buildIndex() adds to the value index
+            uint64_t indexEnd = 0;           // positions from here on were indexed when pushed
+            bool indexDirty = false;
+        };
     public:
         static const std::string kType;
+        static const size_t kCompactHoles = 64;     // deleted positions before the flush compacts
+        static const size_t kCompactMoves = 64;     // elements moved by the flush
+        static const size_t kIteratorBatch = 64;    // elements read per host call by the iterators
     private:
-        std::map<int, Item> cache_;
-        std::vector<bool> mark_;
-        size_t maxNumber_ = 0;
-        size_t size_ = 0;
-        const std::string name_ = kType + Name;
-        const std::string maxNumberKey_ = name_ + "maxNumber";
-        const std::string sizeKey_ = name_ + "size";
+        std::shared_ptr<Core> core_ = sharedState<Core>();
+        CacheTable<size_t, Item> &cache_ = core_->cache;
+        std::vector<bool> &mark_ = core_->mark;
+        RankIndex &rank_ = core_->rank;
+        size_t &maxNumber_ = core_->maxNumber;
+        size_t &size_ = core_->size;
+        const std::string &name_ = generation().prefix();
     };
-    template <const char *Name, typename Key>
-    const std::string List<Name, Key>::kType = "__list__";
+    template <const char *Name, typename Key, ListIndex valueIndex>
+    const std::string List<Name, Key, valueIndex>::kType = "__list__";
 }
 }
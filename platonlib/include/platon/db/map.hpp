@@ -10,6 +10,10 @@
 #include "platon/storage.hpp"
 #include "platon/serialize.hpp"
 #include "platon/print.hpp"
+#include "platon/db/generation.hpp"
+#include "platon/db/bloom.hpp"
+#include "platon/db/keyindex.hpp"
+#include "platon/db/cachetable.hpp"
 
 /**
  * @brief Implement map operation
@@ -26,6 +30,15 @@ namespace platon {
         NoTraverse = 1
     };
 
+    /**
+     * @brief Plain keys store the serialized name and key, Hashed keys store their 32 byte Keccak-256 digest
+     *
+     */
+    enum class MapKey {
+        Plain = 0,
+        Hashed = 1
+    };
+
     /**
      * @brief Implement map operations, Map templates
      * 
@@ -33,10 +46,15 @@ namespace platon {
      * @tparam Key key的类型
      * @tparam Value value的类型
      * @tparam MapType::Traverse The default is Traverse, when Traverse needs extra data structure to operate, set to NoTraverse when no traversal operation is needed. 
+     * @tparam MapKey::Plain The default is Plain, set to Hashed to bound the length of long or composite keys. Iterators still return the plain keys.
+     * @tparam BloomBits Size of a Bloom filter of the keys, persisted with the map. 0 disables it, only a NoTraverse map can have one.
+     * The filter answers lookups only after buildBloom(), a map that held values before needs all of its keys there.
      */
-    template <const char *Name, typename Key, typename Value, MapType type = MapType::Traverse>
+    template <const char *Name, typename Key, typename Value, MapType type = MapType::Traverse, MapKey keyMode = MapKey::Plain,
+              unsigned BloomBits = 0>
     class Map{
     public:
+        static_assert(BloomBits == 0 || type == MapType::NoTraverse, "Traverse map knows its keys, it needs no bloom filter");
         //template <const char *Name, typename Key, typename Value>
 
         class Pair {
@@ -125,6 +143,32 @@ namespace platon {
             const Key& key_;
         };
 
+        typedef typename std::conditional<keyMode == MapKey::Hashed, StateDigest, KeyWrapper>::type StateKeyType;
+
+        /**
+         * @brief Serialized like KeyWrapper of the equal string key
+         *
+         */
+        class KeyRefWrapper {
+        public:
+            KeyRefWrapper(const std::string &name, const StringRef &key) :name_(name), key_(key) {
+            }
+            PLATON_SERIALIZE(KeyRefWrapper, (name_)(key_))
+        private:
+            const std::string &name_;
+            const StringRef &key_;
+        };
+
+        typedef typename std::conditional<keyMode == MapKey::Hashed, StateDigest, KeyRefWrapper>::type StateKeyRefType;
+
+        /**
+         * @brief Enables the overloads that look up a string key by const char *, bytes or StringRef
+         *
+         */
+        template <typename K>
+        using EnableStringRef = typename std::enable_if<IsStringKey<Key>::value && !std::is_same<K, Key>::value
+                && std::is_convertible<const K&, StringRef>::value>::type;
+
         /**
          * @brief Constant Pair
          * 
@@ -209,7 +253,7 @@ namespace platon {
              * @param map 
              * @param iter 
              */
-            IteratorType(Map<Name, Key, Value, type> *map, ItemIterator iter)
+            IteratorType(Map<Name, Key, Value, type, keyMode, BloomBits> *map, ItemIterator iter)
                 :map_(map), iter_(iter){
             }
 
@@ -219,12 +263,12 @@ namespace platon {
              * @return Pair& 
              */
             Pair& operator*() {
-                pair_ = Pair(*iter_, (*map_)[*iter_]);
+                pair_ = Pair(*iter_, map_->load(*iter_).value);
                 return pair_;
             }
 
             Pair* operator->() {
-                pair_ = Pair(*iter_, (*map_)[*iter_]);
+                pair_ = Pair(*iter_, map_->load(*iter_).value);
                 return &pair_;
             }
 
@@ -251,7 +295,7 @@ namespace platon {
             }
         private:
             Pair pair_;
-            Map<Name, Key, Value, type> *map_;
+            Map<Name, Key, Value, type, keyMode, BloomBits> *map_;
             ItemIterator iter_;
         };
 
@@ -280,7 +324,7 @@ namespace platon {
              * @param map 
              * @param iter 
              */
-            ConstIteratorType(Map<Name, Key, Value, type> *map, ItemIterator iter)
+            ConstIteratorType(Map<Name, Key, Value, type, keyMode, BloomBits> *map, ItemIterator iter)
                     :map_(map), iter_(iter){
             }
 
@@ -322,26 +366,126 @@ namespace platon {
             }
         private:
             ConstPair pair_;
-            Map<Name, Key, Value, type> *map_;
+            Map<Name, Key, Value, type, keyMode, BloomBits> *map_;
             ItemIterator iter_;
         };
 
-        typedef class IteratorType<typename std::set<Key>::iterator> Iterator;
-        typedef class IteratorType<typename std::set<Key>::reverse_iterator> ReverseIterator;
-        typedef class ConstIteratorType<typename std::set<Key>::iterator> ConstIterator;
-        typedef class ConstIteratorType<typename std::set<Key>::reverse_iterator> ConstReverseIterator;
+        typedef KeyIndex<Key> Index;
+        typedef typename CacheTable<Key, Value>::Entry Entry;
+
+        /**
+         * @brief State of a cache entry
+         *
+         */
+        enum : uint8_t {
+            kCached = 1,    // value is loaded
+            kDirty = 2,     // value is written by flush
+            kDeleted = 4,   // key is deleted by flush
+            kSnapshot = 8   // value was found on the blockchain, written by flush if changed
+        };
+
+        /**
+         * @brief Read-only cursor over a key range. Values are read in batches of getStates,
+         * nothing is cached in the map or written back.
+         *
+         */
+        class Cursor {
+        public:
+            /**
+             * @brief Construct a new Cursor object
+             *
+             * @param map Map
+             * @param begin First key
+             * @param end End of the range
+             * @param batch Number of values read per host call
+             */
+            Cursor(Map *map, typename Index::Iterator begin, typename Index::Iterator end, size_t batch)
+                :map_(map), iter_(begin), end_(end), batch_(batch == 0 ? 1 : batch) {
+                fetch();
+            }
+
+            /**
+             * @brief Whether the cursor is on an element
+             *
+             * @return true
+             * @return false
+             */
+            bool valid() const {
+                return pos_ < keys_.size();
+            }
+
+            const Key& key() const {
+                return keys_[pos_];
+            }
+
+            const Value& value() const {
+                return values_[pos_];
+            }
+
+            /**
+             * @brief Move to the next element, reads the next batch when needed
+             *
+             */
+            void next() {
+                if (++pos_ >= keys_.size()) {
+                    fetch();
+                }
+            }
+        private:
+            void fetch() {
+                keys_.clear();
+                values_.clear();
+                pos_ = 0;
+                // state keys refer to the elements of keys_, which must not reallocate
+                keys_.reserve(batch_);
+                std::vector<StateKeyType> stateKeys;
+                std::vector<size_t> slots;
+                for (; iter_ != end_ && keys_.size() < batch_; ++iter_) {
+                    keys_.push_back(*iter_);
+                    values_.push_back(Value());
+                    const Entry *cached = map_->cache_.find(keys_.back());
+                    if (cached != nullptr && (cached->flags & kCached)) {
+                        values_.back() = cached->value;
+                    } else {
+                        stateKeys.push_back(map_->stateKey(keys_.back()));
+                        slots.push_back(keys_.size() - 1);
+                    }
+                }
+                if (stateKeys.empty()) {
+                    return;
+                }
+                std::vector<Value> values;
+                platon::getStates(stateKeys, values);
+                for (size_t i = 0; i < slots.size(); ++i) {
+                    values_[slots[i]] = std::move(values[i]);
+                }
+            }
+
+            Map *map_;
+            typename Index::Iterator iter_;
+            typename Index::Iterator end_;
+            size_t batch_;
+            std::vector<Key> keys_;
+            std::vector<Value> values_;
+            size_t pos_ = 0;
+        };
+
+        typedef class IteratorType<typename Index::Iterator> Iterator;
+        typedef class IteratorType<typename Index::ReverseIterator> ReverseIterator;
+        typedef class ConstIteratorType<typename Index::Iterator> ConstIterator;
+        typedef class ConstIteratorType<typename Index::ReverseIterator> ConstReverseIterator;
     public:
 
         Map(){}
-        Map(const Map<Name, Key, Value, type> &) = delete;
-        Map(const Map<Name, Key, Value, type> &&) = delete;
-        Map<Name, Key, Value, type>& operator=(const Map<Name, Key, Value, type> &) = delete;
+        Map(const Map<Name, Key, Value, type, keyMode, BloomBits> &) = delete;
+        Map(const Map<Name, Key, Value, type, keyMode, BloomBits> &&) = delete;
+        Map<Name, Key, Value, type, keyMode, BloomBits>& operator=(const Map<Name, Key, Value, type, keyMode, BloomBits> &) = delete;
         /**
-         * @brief Destroy the Map object Refresh data to the blockchain
+         * @brief Destroy the Map object. The cache is shared by the Map objects of the same
+         * type in the call, it is written to the blockchain once, see sharedState().
          * 
          */
         ~Map(){
-            flush();
         }
 
 
@@ -354,12 +498,32 @@ namespace platon {
          * @return false Insert failed
          */
         bool insert(const Key &k, const Value &v) {
-            init();
-            map_[k] = v;
-            modify_.insert(k);
-            if (type == MapType::Traverse) {
-                keySet_.insert(k);
-            }
+            modify(k).value = v;
+            return true;
+        }
+
+        /**
+         * @brief Insert a new key-value pair, the value is moved into the cache
+         *
+         * @param k Key
+         * @param v Value
+         * @return true Inserted successfully
+         */
+        bool insert(const Key &k, Value &&v) {
+            modify(k).value = std::move(v);
+            return true;
+        }
+
+        /**
+         * @brief Insert a value constructed from args
+         *
+         * @param k Key
+         * @param args Arguments of a Value constructor
+         * @return true Inserted successfully
+         */
+        template <typename... Args>
+        bool emplace(const Key &k, Args&&... args) {
+            modify(k).value = Value(std::forward<Args>(args)...);
             return true;
         }
 
@@ -373,17 +537,15 @@ namespace platon {
          * @return false Insert failed
          */
         bool insertConst(const Key &k, const Value &v) {
-            init();
-            if (type == MapType::Traverse) {
-                keySet_.insert(k);
-            }
-
-            if (map_.find(k) != map_.end()) {
-                map_[k] = v;
-            }
+            return writeConst(k, v);
+        }
 
-            setState(KeyWrapper(keySetName_, k), v);
-            return true;
+        /**
+         * @brief insertConst() that moves the value into the cache if the key is cached
+         *
+         */
+        bool insertConst(const Key &k, Value &&v) {
+            return writeConst(k, std::move(v));
         }
 
         /**
@@ -393,38 +555,80 @@ namespace platon {
          * @return Value 
          */
         Value getConst(const Key &k) {
-            init();
-            auto iter = map_.find(k);
-            if (iter != map_.end()) {
-                return iter->second;
-            }
+            return readConst(k);
+        }
 
-            Value v;
-            platon::getState(KeyWrapper(keySetName_, k), v);
-            return v;
+        /**
+         * @brief getConst() of a string key by const char *, bytes or StringRef, no key is built
+         *
+         */
+        template <typename K, typename = EnableStringRef<K>>
+        Value getConst(const K &k) {
+            return readConst(StringRef(k));
         }
 
         /**
-         * @brief Get value, will be added to the cache
+         * @brief Get value, will be added to the cache. A value read from the blockchain is
+         * written back by flush() only when its serialized form changed.
          * 
          * @param k Key
          * @return Value& 
          */
         Value& get(const Key &k) {
             init();
-            auto iter = map_.find(k);
-            if (iter != map_.end()) {
-                return iter->second;
+            Entry &e = load(k);
+            if ((e.flags & (kSnapshot | kDirty)) == 0) {
+                e.flags = kCached | kDirty;
+                if (type == MapType::Traverse) {
+                    index_.insert(k);
+                }
             }
+            return e.value;
+        }
 
-            Value v;
-            platon::getState(KeyWrapper(keySetName_, k), v);
-            if (type == MapType::Traverse) {
-                keySet_.insert(k);
+        /**
+         * @brief get() of a string key by const char *, bytes or StringRef. A cache hit builds
+         * no key.
+         *
+         */
+        template <typename K, typename = EnableStringRef<K>>
+        Value& get(const K &key) {
+            init();
+            StringRef k(key);
+            Entry *e = cache_.find(k);
+            if (e != nullptr && (e->flags & (kSnapshot | kDirty))) {
+                return e->value;
             }
-            map_[k] = v;
-            modify_.insert(k);
-            return map_[k];
+            return get(Key(k.data(), k.data() + k.size()));
+        }
+
+        /**
+         * @brief Whether the key has a value. Misses are answered by the key set of a Traverse map
+         * or the bloom filter, other keys only read the length of the value.
+         *
+         * @param k Key
+         * @return true
+         * @return false
+         */
+        bool contains(const Key &k) {
+            return lookup(k);
+        }
+
+        /**
+         * @brief contains() of a string key by const char *, bytes or StringRef, no key is built
+         *
+         */
+        template <typename K, typename = EnableStringRef<K>>
+        bool contains(const K &k) {
+            return lookup(StringRef(k));
+        }
+
+        /**
+         * @brief Same as contains()
+         *
+         */
+        bool exists(const Key &k) {
+            return contains(k);
         }
 
         /**
@@ -434,14 +638,13 @@ namespace platon {
          */
         void del(const Key &k) {
             init();
-            auto iter = map_.find(k);
-            if (iter != map_.end()) {
-                map_.erase(iter);
-            }
+            Entry &e = entry(k);
+            e.value = Value();
+            e.snapshot.clear();
+            e.flags = kDeleted;
             if (type == MapType::Traverse) {
-                keySet_.erase(k);
+                index_.erase(k);
             }
-            modify_.insert(k);
         }
 
         /**
@@ -455,12 +658,11 @@ namespace platon {
             return get(k);
         }
 
-//        Value& operator[]( Key&& k ) {
-//            init();
-//            Value & v = map_[k];
-//            modify_.insert(v);
-//            return v;
-//        }
+        template <typename K, typename = EnableStringRef<K>>
+        Value& operator[](const K &k) {
+            return get(k);
+        }
+
         /**
          * @brief Get the length of the map, only allowed when the MapType is Traverse
          * 
@@ -469,33 +671,126 @@ namespace platon {
         size_t size() {
             init();
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return keySet_.size();
+            return index_.size();
+        }
+        /**
+         * @brief Remove all key-value pairs with a constant number of writes, only allowed when
+         * the MapType is Traverse. The old pairs become unreachable, sweep() deletes them from
+         * the blockchain.
+         *
+         */
+        void clear() {
+            init();
+            PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
+            // deleted keys already left the key index, so sweep() will not reach their values
+            StateBatch batch;
+            for (Entry &e : cache_) {
+                if (e.flags & kDeleted) {
+                    batch.del(stateKey(e.key));
+                }
+            }
+            index_.flush(batch);
+            batch.commit();
+            generation().next();
+            index_.reset();
+            cache_.clear();
         }
+
+        /**
+         * @brief Delete up to limit pairs left behind by clear(), only allowed when the MapType
+         * is Traverse
+         *
+         * @param limit Maximum number of pairs and key index pages deleted
+         * @return size_t Number of pairs and pages deleted, 0 when nothing is left
+         */
+        size_t sweep(size_t limit) {
+            PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
+            Generation &gen = generation();
+            if (!gen.pending()) {
+                return 0;
+            }
+            StateBatch batch;
+            size_t removed = 0;
+            while (gen.pending() && removed < limit) {
+                std::string name = gen.prefix(gen.swept());
+                if (Index::stored(name)) {
+                    uint64_t cursor = gen.cursor();
+                    removed += Index::sweep(name, cursor, limit - removed, batch, [&batch, &name](const Key &k) {
+                        batch.del(StateKeyType(KeyWrapper(name, k)));
+                    });
+                    if (cursor == 0) {
+                        gen.advance();
+                    } else {
+                        gen.seek(cursor);
+                    }
+                    continue;
+                }
+                std::set<Key> keys;
+                platon::getState(name, keys);
+                auto iter = keys.begin();
+                for (uint64_t i = 0; i < gen.cursor() && iter != keys.end(); ++i) {
+                    ++iter;
+                }
+                for (; iter != keys.end() && removed < limit; ++iter, ++removed) {
+                    batch.del(StateKeyType(KeyWrapper(name, *iter)));
+                    gen.step(1);
+                }
+                if (iter == keys.end()) {
+                    batch.del(name);
+                    gen.advance();
+                }
+            }
+            batch.commit();
+            gen.save();
+            return removed;
+        }
+
         /**
          * @brief Refresh the modified data in memory to the blockchain
          * 
          */
         void flush() {
-            std::for_each(
-                    modify_.begin(),
-                    modify_.end(),
-                    [this](const Key &k) {
-                        auto iter = map_.find(k);
-                        if (iter != map_.end()) {
-                            platon::setState(KeyWrapper(keySetName_, k), iter->second);
-                        } else {
-                            platon::delState(k);
-                            if (type == MapType::Traverse) {
-                                keySet_.erase(k);
-                            }
-                        }
-                    }
-            );
-            if (type == MapType::Traverse) {
-                setState(keySetName_, keySet_);
+            core_->flush();
+        }
+
+        /**
+         * @brief Bound the cache of the map, shared by the Map objects of the call. Adding a
+         * key to a full cache writes back and evicts cold entries, so long batch jobs run in
+         * bounded memory. A reference returned by get() may be invalidated by the second
+         * key added after it, keep it no longer than one expression.
+         *
+         * @param entries Maximum number of cached entries, 0 is unbounded
+         */
+        void setCacheLimit(size_t entries) {
+            cache_.setLimit(entries);
+        }
+
+        /**
+         * @brief Build the bloom filter of a NoTraverse map. Until it is built the filter
+         * answers nothing and every miss reads the blockchain. Call it once, in the call
+         * that creates the map, or with every key of a map that already holds values;
+         * a key left out is reported missing and its value overwritten by get().
+         *
+         * @param keys Keys the map already holds
+         */
+        void buildBloom(const std::vector<Key> &keys = std::vector<Key>()) {
+            static_assert(BloomBits != 0, "map has no bloom filter");
+            bloom_.build();
+            for (const Key &k : keys) {
+                addBloom(bloom_, k);
             }
         }
 
+        /**
+         * @brief Whether the bloom filter was built, see buildBloom()
+         *
+         * @return true
+         * @return false
+         */
+        bool bloomBuilt() {
+            return bloom_.built(generation().key(0));
+        }
+
         /**
          * @brief Iterator start position
          * 
@@ -503,7 +798,7 @@ namespace platon {
          */
         Iterator begin() {
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return Iterator(this, keySet_.begin());
+            return Iterator(this, index_.begin());
         }
 
         /**
@@ -513,7 +808,7 @@ namespace platon {
          */
         Iterator end() {
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return Iterator(this, keySet_.end());
+            return Iterator(this, index_.end());
         }
 
         /**
@@ -523,7 +818,7 @@ namespace platon {
          */
         ReverseIterator rbegin() {
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return ReverseIterator(this, keySet_.rbegin());
+            return ReverseIterator(this, index_.rbegin());
         }
 
         /**
@@ -533,7 +828,7 @@ namespace platon {
          */
         ReverseIterator rend() {
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return ReverseIterator(this, keySet_.rend());
+            return ReverseIterator(this, index_.rend());
         }
 
         /**
@@ -543,7 +838,7 @@ namespace platon {
          */
         ConstIterator cbegin() {
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return ConstIterator(this, keySet_.begin());
+            return ConstIterator(this, index_.begin());
         }
 
         /**
@@ -553,7 +848,7 @@ namespace platon {
          */
         ConstIterator cend() {
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return ConstIterator(this, keySet_.end());
+            return ConstIterator(this, index_.end());
         }
 
         /**
@@ -563,7 +858,7 @@ namespace platon {
          */
         ConstReverseIterator crbegin() {
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return ConstReverseIterator(this, keySet_.crbegin());
+            return ConstReverseIterator(this, index_.rbegin());
         }
 
         /**
@@ -573,31 +868,347 @@ namespace platon {
          */
         ConstReverseIterator crend() {
             PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
-            return ConstReverseIterator(this, keySet_.crend());
+            return ConstReverseIterator(this, index_.rend());
+        }
+
+        /**
+         * @brief First element whose key is not less than k, only allowed when the MapType is Traverse
+         *
+         * @param k Key
+         * @return ConstIterator
+         */
+        ConstIterator lower_bound(const Key &k) {
+            PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
+            return ConstIterator(this, index_.lower_bound(k));
+        }
+
+        /**
+         * @brief First element whose key is greater than k, only allowed when the MapType is Traverse
+         *
+         * @param k Key
+         * @return ConstIterator
+         */
+        ConstIterator upper_bound(const Key &k) {
+            PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
+            return ConstIterator(this, index_.upper_bound(k));
+        }
+
+        /**
+         * @brief Read-only cursor over all elements, only allowed when the MapType is Traverse
+         *
+         * @param batch Number of values read per host call
+         * @return Cursor
+         */
+        Cursor scan(size_t batch = 64) {
+            PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
+            return Cursor(this, index_.begin(), index_.end(), batch);
+        }
+
+        /**
+         * @brief Read-only cursor over the keys in [first, last), only allowed when the MapType is Traverse
+         *
+         * @param first First key
+         * @param last End of the range
+         * @param batch Number of values read per host call
+         * @return Cursor
+         */
+        Cursor range(const Key &first, const Key &last, size_t batch = 64) {
+            PlatonAssert(type == MapType::Traverse, "NoTraverse of Map", keySetName_);
+            if (!(first < last)) {
+                return Cursor(this, index_.end(), index_.end(), batch);
+            }
+            return Cursor(this, index_.lower_bound(first), index_.lower_bound(last), batch);
         }
 
     public:
         static const std::string kType;
     private:
+        /**
+         * @brief Key prefix of the map, also the key of the key set
+         *
+         * @return const std::string&
+         */
+        static const std::string& prefix() {
+            static const std::string prefix = statePrefix<Name>(kType, 'm');
+            return prefix;
+        }
+
+        /**
+         * @brief Generation of the map, the prefix of the current generation is the key of the key set,
+         * its fixed key is the key of the bloom filter
+         *
+         * @return Generation&
+         */
+        static Generation& generation() {
+            static Generation gen(prefix(), {"#bloom"});
+            gen.load();
+            return gen;
+        }
+
+        /**
+         * @brief Key of a value on the blockchain
+         *
+         * @param k Key
+         * @return StateKeyType
+         */
+        static StateKeyType stateKey(const Key &k) {
+            return StateKeyType(KeyWrapper(generation().prefix(), k));
+        }
+
+        static StateKeyRefType stateKey(const StringRef &k) {
+            return StateKeyRefType(KeyRefWrapper(generation().prefix(), k));
+        }
+
+        /**
+         * @brief Cache entry of a key, cold entries are written back and evicted first when
+         * the cache is full
+         *
+         */
+        Entry& entry(const Key &k) {
+            if (cache_.full() && cache_.find(k) == nullptr) {
+                core_->spill();
+            }
+            return cache_.get(k);
+        }
+
+        /**
+         * @brief Cache entry of a key marked for writing
+         *
+         */
+        Entry& modify(const Key &k) {
+            init();
+            Entry &e = entry(k);
+            e.flags = kCached | kDirty;
+            if (type == MapType::Traverse) {
+                index_.insert(k);
+            }
+            return e;
+        }
+
+        /**
+         * @brief Write a value, a cached entry takes it over
+         *
+         */
+        template <typename V>
+        bool writeConst(const Key &k, V &&v) {
+            init();
+            if (type == MapType::Traverse) {
+                index_.insert(k);
+            }
+            addBloom(bloom_, k);
+
+            Entry *e = cache_.find(k);
+            if (e != nullptr && (e->flags & kCached)) {
+                e->value = std::forward<V>(v);
+                e->flags &= ~kDeleted;
+                if (e->flags & kSnapshot) {
+                    e->snapshot = encodeState(e->value);
+                }
+                setState(stateKey(k), e->value);
+                return true;
+            } else if (e != nullptr) {
+                e->flags = 0;
+            }
+            setState(stateKey(k), v);
+            return true;
+        }
+
+        /**
+         * @brief Value of a key or StringRef without caching it
+         *
+         */
+        template <typename K>
+        Value readConst(const K &k) {
+            init();
+            const Entry *e = cache_.find(k);
+            if (e != nullptr && (e->flags & kCached)) {
+                return e->value;
+            }
+
+            Value v = Value();
+            if (stored(k)) {
+                platon::getState(stateKey(k), v);
+            }
+            return v;
+        }
+
+        /**
+         * @brief Whether a key or StringRef has a value
+         *
+         */
+        template <typename K>
+        bool lookup(const K &k) {
+            init();
+            const Entry *e = cache_.find(k);
+            if (e != nullptr && (e->flags & kCached)) {
+                return true;
+            }
+            if (!stored(k)) {
+                return false;
+            }
+            return type == MapType::Traverse || hasState(stateKey(k));
+        }
+
+        /**
+         * @brief Cache entry of a key for reading, not marked for flush.
+         * A value found on the blockchain keeps its serialized form as snapshot.
+         *
+         * @param k Key
+         * @return Entry&
+         */
+        Entry& load(const Key &k) {
+            Entry &e = entry(k);
+            if (e.flags & kCached) {
+                return e;
+            }
+            e.value = Value();
+            if (stored(k) && platon::getState(stateKey(k), e.value) != 0) {
+                e.snapshot = encodeState(e.value);
+                e.flags |= kSnapshot;
+            }
+            e.flags |= kCached;
+            return e;
+        }
+
+        /**
+         * @brief Whether the blockchain may have a value of a key that is not in the cache.
+         * false is exact, true may need a read.
+         *
+         * @param k Key or StringRef
+         * @return true
+         * @return false
+         */
+        template <typename K>
+        bool stored(const K &k) {
+            const Entry *e = cache_.find(k);
+            if (e != nullptr && (e->flags & kDeleted)) {
+                return false;
+            }
+            if (type == MapType::Traverse) {
+                return index_.contains(k);
+            }
+            if (BloomBits == 0) {
+                return true;
+            }
+            StateBytes<kStateKeyInline> bytes;
+            encodeState(bytes, k);
+            return bloom_.mayContain(bytes.data(), bytes.size(), generation().key(0));
+        }
+
+        /**
+         * @brief Add a key to the bloom filter
+         *
+         * @param bloom Bloom filter
+         * @param k Key
+         */
+        static void addBloom(BloomFilter<BloomBits> &bloom, const Key &k) {
+            if (BloomBits == 0) {
+                return;
+            }
+            StateBytes<kStateKeyInline> bytes;
+            encodeState(bytes, k);
+            bloom.add(bytes.data(), bytes.size(), generation().key(0));
+        }
+
         /**
          * @brief Initialize, get data from the blockchain
          * 
          */
         void init() {
-            if (!init_ && type == MapType::Traverse) {
-                platon::getState(keySetName_, keySet_);
-                init_ = true;
+            if (type == MapType::Traverse) {
+                index_.load();
             }
         }
 
-        std::map<Key, Value> map_;
-        std::set<Key> keySet_;
-        std::set<Key> modify_;
-        const std::string keySetName_ = kType + Name;
-        bool init_ = false;
+        /**
+         * @brief Cache, key index and bloom filter of the map, shared by the Map objects of the call
+         *
+         */
+        struct Core {
+            Core() :index(generation().prefix()) {}
+            ~Core() {
+                flush();
+            }
+
+            /**
+             * @brief Write the changed values, the key index and the bloom filter
+             *
+             */
+            void flush() {
+                StateBatch batch;
+                std::vector<Key> deleted;
+                for (Entry &e : cache) {
+                    if (e.flags & kDeleted) {
+                        deleted.push_back(e.key);
+                    }
+                    write(batch, e);
+                }
+                for (const Key &k : deleted) {
+                    cache.erase(k);
+                }
+                index.flush(batch);
+                bloom.flush(batch, generation().key(0));
+                batch.commit();
+            }
+
+            /**
+             * @brief Drop the cached entries, the key index and the bloom filter without
+             * writing them
+             *
+             */
+            void reload() {
+                cache.clear();
+                generation().reload();
+                index.reset();
+                bloom.unload();
+            }
+
+            /**
+             * @brief Evict cold entries, their changes are written first
+             *
+             */
+            void spill() {
+                StateBatch batch;
+                cache.shrink([&](Entry &e) { write(batch, e); });
+                batch.commit();
+            }
+
+            /**
+             * @brief Add the change of an entry to a batch. A written value becomes a clean
+             * snapshot, so it is written again only if it changes; deleted entries are
+             * dropped by the caller.
+             *
+             */
+            void write(StateBatch &batch, Entry &e) {
+                if (e.flags & kDeleted) {
+                    batch.del(stateKey(e.key));
+                } else if (e.flags & kDirty) {
+                    addBloom(bloom, e.key);
+                    batch.set(stateKey(e.key), e.value);
+                    e.snapshot = encodeState(e.value);
+                    e.flags = kCached | kSnapshot;
+                } else if (e.flags & kSnapshot) {
+                    std::string bytes = encodeState(e.value);
+                    if (bytes != e.snapshot) {
+                        batch.set(stateKey(e.key), e.value);
+                        e.snapshot = std::move(bytes);
+                    }
+                }
+            }
+
+            CacheTable<Key, Value> cache;
+            Index index;
+            BloomFilter<BloomBits> bloom;
+        };
+
+        std::shared_ptr<Core> core_ = sharedState<Core>();
+        CacheTable<Key, Value> &cache_ = core_->cache;
+        Index &index_ = core_->index;
+        BloomFilter<BloomBits> &bloom_ = core_->bloom;
+        const std::string &keySetName_ = generation().prefix();
     };
 
-    template <const char *Name, typename Key, typename Value, MapType type>
-    const std::string Map<Name, Key, Value, type>::kType = "__map__";
+    template <const char *Name, typename Key, typename Value, MapType type, MapKey keyMode, unsigned BloomBits>
+    const std::string Map<Name, Key, Value, type, keyMode, BloomBits>::kType = "__map__";
 }
 }
\ No newline at end of file
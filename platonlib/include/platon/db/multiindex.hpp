@@ -0,0 +1,572 @@
+//
+// Table of records with secondary indexes kept in state
+//
+
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "platon/storage.hpp"
+#include "platon/serialize.hpp"
+#include "platon/db/cachetable.hpp"
+#include "platon/db/keyindex.hpp"
+
+namespace platon {
+namespace db {
+    /**
+     * @brief Index key read from a data member of the record
+     *
+     * Example:
+     * @code
+     * typedef platon::db::IndexMember<Task, uint64_t, &Task::id> TaskId;
+     * @endcode
+     *
+     * @tparam Record Record type
+     * @tparam Type Member type
+     * @tparam Member Pointer to the member
+     */
+    template <typename Record, typename Type, Type Record::*Member>
+    struct IndexMember {
+        typedef Type KeyType;
+        static const KeyType& key(const Record &r) {
+            return r.*Member;
+        }
+    };
+
+    /**
+     * @brief Index key returned by a const member function of the record
+     *
+     * @tparam Record Record type
+     * @tparam Type Return type
+     * @tparam Method Pointer to the member function
+     */
+    template <typename Record, typename Type, Type (Record::*Method)() const>
+    struct IndexMethod {
+        typedef Type KeyType;
+        static KeyType key(const Record &r) {
+            return (r.*Method)();
+        }
+    };
+
+    /**
+     * @brief Table of records addressed by a primary key, with any number of non-unique
+     * secondary indexes. Every index is a KeyIndex of (index key, primary key) pairs that is
+     * updated by insert(), modify() and erase(), so an index is searched and iterated without
+     * reading the records. Records and index pages are written back by flush() once the last
+     * table object of the call is gone, the objects of one name share them, see sharedState().
+     *
+     * Example:
+     * @code
+     * struct Task {
+     *     uint64_t id;
+     *     uint8_t status;
+     *     std::string owner;
+     *     PLATON_SERIALIZE(Task, (id)(status)(owner))
+     * };
+     * extern char taskName[] = "task";
+     * typedef platon::db::MultiIndex<taskName, Task,
+     *         platon::db::IndexMember<Task, uint64_t, &Task::id>,
+     *         platon::db::IndexMember<Task, uint8_t, &Task::status>,
+     *         platon::db::IndexMember<Task, std::string, &Task::owner>> Tasks;
+     * Tasks tasks;
+     * tasks.insert(Task{1, 0, "alice"});
+     * tasks.modify(1, [](Task &t) { t.status = 1; });
+     * auto byStatus = tasks.index<0>();
+     * for (auto iter = byStatus.lower_bound(1); iter != byStatus.upper_bound(1); ++iter) {
+     *     const Task *task = tasks.find(iter.primaryKey());
+     * }
+     * @endcode
+     *
+     * @tparam Name The name of the table, globally unique
+     * @tparam Record Record type
+     * @tparam PrimaryKey Extractor of the primary key, IndexMember or IndexMethod
+     * @tparam Indexes Extractors of the secondary indexes
+     */
+    template <const char *Name, typename Record, typename PrimaryKey, typename... Indexes>
+    class MultiIndex {
+    public:
+        static_assert(sizeof...(Indexes) < 256, "too many indexes");
+        typedef typename PrimaryKey::KeyType Key;
+        static const std::string kType;
+
+        /**
+         * @brief Extractor of the secondary index N
+         *
+         * @tparam N Index
+         */
+        template <size_t N>
+        using Extractor = typename std::tuple_element<N, std::tuple<Indexes...>>::type;
+
+        /**
+         * @brief Ordered view of the secondary index N. Changing the table invalidates the
+         * iterators of its views.
+         *
+         * @tparam N Index
+         */
+        template <size_t N>
+        class IndexView {
+        public:
+            typedef typename Extractor<N>::KeyType IndexKey;
+            typedef KeyIndex<std::tuple<IndexKey, Key>> Tree;
+
+            /**
+             * @brief Bidirectional iterator ordered by index key, then primary key
+             *
+             */
+            class Iterator {
+            public:
+                friend bool operator == (const Iterator &a, const Iterator &b) {
+                    return a.iter_ == b.iter_;
+                }
+                friend bool operator != (const Iterator &a, const Iterator &b) {
+                    return !(a == b);
+                }
+
+                explicit Iterator(typename Tree::Iterator iter) :iter_(iter) {}
+
+                /**
+                 * @brief Index key of the record
+                 *
+                 * @return const IndexKey&
+                 */
+                const IndexKey& key() const {
+                    return std::get<0>(*iter_);
+                }
+
+                /**
+                 * @brief Primary key of the record
+                 *
+                 * @return const Key&
+                 */
+                const Key& primaryKey() const {
+                    return std::get<1>(*iter_);
+                }
+
+                Iterator& operator++() {
+                    ++iter_;
+                    return *this;
+                }
+
+                Iterator operator++(int) {
+                    return Iterator(iter_++);
+                }
+
+                Iterator& operator--() {
+                    --iter_;
+                    return *this;
+                }
+
+                Iterator operator--(int) {
+                    return Iterator(iter_--);
+                }
+            private:
+                typename Tree::Iterator iter_;
+            };
+
+            explicit IndexView(Tree &tree) :tree_(tree) {}
+
+            Iterator begin() {
+                return Iterator(tree_.begin());
+            }
+
+            Iterator end() {
+                return Iterator(tree_.end());
+            }
+
+            /**
+             * @brief First record whose index key is not less than k
+             *
+             */
+            Iterator lower_bound(const IndexKey &k) {
+                return Iterator(tree_.partition_point([&k](const std::tuple<IndexKey, Key> &e) {
+                    return std::get<0>(e) < k;
+                }));
+            }
+
+            /**
+             * @brief First record whose index key is greater than k
+             *
+             */
+            Iterator upper_bound(const IndexKey &k) {
+                return Iterator(tree_.partition_point([&k](const std::tuple<IndexKey, Key> &e) {
+                    return !(k < std::get<0>(e));
+                }));
+            }
+
+            /**
+             * @brief Records whose index key equals k
+             *
+             * @return std::pair<Iterator, Iterator> First and end of the range
+             */
+            std::pair<Iterator, Iterator> equal_range(const IndexKey &k) {
+                return std::make_pair(lower_bound(k), upper_bound(k));
+            }
+
+            /**
+             * @brief Number of records whose index key equals k, only the index is read
+             *
+             */
+            size_t count(const IndexKey &k) {
+                size_t n = 0;
+                for (Iterator iter = lower_bound(k), last = upper_bound(k); iter != last; ++iter) {
+                    ++n;
+                }
+                return n;
+            }
+
+        private:
+            Tree &tree_;
+        };
+
+        MultiIndex() {}
+        MultiIndex(const MultiIndex &) = delete;
+        MultiIndex& operator=(const MultiIndex &) = delete;
+
+        /**
+         * @brief Destroy the MultiIndex object. The changes are written once the last object
+         * of the same name in the call is gone, see sharedState().
+         *
+         */
+        ~MultiIndex() {
+        }
+
+        /**
+         * @brief Insert a record and add it to every index
+         *
+         * @param r Record
+         * @return true Inserted
+         * @return false A record with the same primary key exists
+         */
+        bool insert(const Record &r) {
+            if (contains(PrimaryKey::key(r))) {
+                return false;
+            }
+            add(r);
+            return true;
+        }
+
+        /**
+         * @brief Insert a record moved into the cache
+         *
+         * @param r Record
+         * @return true Inserted
+         * @return false A record with the same primary key exists, r is left unchanged
+         */
+        bool insert(Record &&r) {
+            if (contains(PrimaryKey::key(r))) {
+                return false;
+            }
+            add(std::move(r));
+            return true;
+        }
+
+        /**
+         * @brief Insert a record constructed from args
+         *
+         * @param args Arguments of a Record constructor
+         * @return true Inserted
+         * @return false A record with the same primary key exists
+         */
+        template <typename... Args>
+        bool emplace(Args&&... args) {
+            return insert(Record(std::forward<Args>(args)...));
+        }
+
+        /**
+         * @brief Whether a record has the primary key, only the primary index is read
+         *
+         * @param k Primary key
+         * @return true
+         * @return false
+         */
+        bool contains(const Key &k) {
+            const Entry *e = cache_.find(k);
+            if (e != nullptr && (e->flags & kCached)) {
+                return (e->flags & kExists) != 0;
+            }
+            return primary_.contains(k);
+        }
+
+        /**
+         * @brief Record of a primary key. The pointer stays valid until the record is erased
+         * or a Savepoint is rolled back.
+         *
+         * @param k Primary key
+         * @return const Record* nullptr if there is no record
+         */
+        const Record* find(const Key &k) {
+            Entry &e = load(k);
+            return (e.flags & kExists) ? &e.value : nullptr;
+        }
+
+        /**
+         * @brief Change a record and update the indexes whose key changed
+         *
+         * @param k Primary key
+         * @param fn Called with the record, must not change the primary key
+         * @return true Modified
+         * @return false There is no record
+         */
+        template <typename Fn>
+        bool modify(const Key &k, Fn fn) {
+            Entry &e = load(k);
+            if ((e.flags & kExists) == 0) {
+                return false;
+            }
+            std::tuple<typename Indexes::KeyType...> keys = indexKeys(e.value, std::index_sequence_for<Indexes...>());
+            fn(e.value);
+            PlatonAssert(equal(PrimaryKey::key(e.value), k), "primary key modified", prefix());
+            updateKeys(keys, e.value, std::index_sequence_for<Indexes...>());
+            e.flags |= kDirty;
+            return true;
+        }
+
+        /**
+         * @brief Erase a record and remove it from every index
+         *
+         * @param k Primary key
+         * @return true Erased
+         * @return false There is no record
+         */
+        bool erase(const Key &k) {
+            Entry &e = load(k);
+            if ((e.flags & kExists) == 0) {
+                return false;
+            }
+            eraseKeys(e.value, std::index_sequence_for<Indexes...>());
+            primary_.erase(k);
+            e.value = Record();
+            e.flags = kCached | kDeleted;
+            return true;
+        }
+
+        /**
+         * @brief Number of records
+         *
+         */
+        size_t size() {
+            return primary_.size();
+        }
+
+        /**
+         * @brief View of the secondary index N
+         *
+         * @tparam N Index
+         * @return IndexView<N>
+         */
+        template <size_t N>
+        IndexView<N> index() {
+            return IndexView<N>(std::get<N>(indexes_));
+        }
+
+        /**
+         * @brief Write the changed records and index pages
+         *
+         */
+        void flush() {
+            core_->flush();
+        }
+
+    private:
+        typedef typename CacheTable<Key, Record>::Entry Entry;
+
+        /**
+         * @brief State of a cache entry
+         *
+         */
+        enum : uint8_t {
+            kCached = 1,    // record is loaded
+            kExists = 2,    // record exists
+            kDirty = 4,     // record is written by flush
+            kDeleted = 8    // record is deleted by flush
+        };
+
+        /**
+         * @brief Key of a record on the blockchain
+         *
+         */
+        class RecordKey {
+        public:
+            RecordKey(const std::string &name, const Key &key) :name_(name), key_(key) {}
+            PLATON_SERIALIZE(RecordKey, (name_)(key_))
+        private:
+            const std::string &name_;
+            const Key &key_;
+        };
+
+        /**
+         * @brief Key prefix of the table, also the prefix of the primary index
+         *
+         * @return const std::string&
+         */
+        static const std::string& prefix() {
+            static const std::string prefix = statePrefix<Name>(kType, 'x');
+            return prefix;
+        }
+
+        /**
+         * @brief Key prefix of a secondary index
+         *
+         * @param i Index
+         * @return const std::string&
+         */
+        static const std::string& indexPrefix(size_t i) {
+            static const std::vector<std::string> prefixes = [] {
+                std::vector<std::string> prefixes;
+                for (size_t i = 0; i < sizeof...(Indexes); ++i) {
+                    prefixes.push_back(prefix() + "#index" + std::string(1, (char)i));
+                }
+                return prefixes;
+            }();
+            return prefixes[i];
+        }
+
+        static bool equal(const Key &a, const Key &b) {
+            return !(a < b) && !(b < a);
+        }
+
+        /**
+         * @brief Cache entry of a primary key, the record is read on first use
+         *
+         */
+        Entry& load(const Key &k) {
+            Entry &e = cache_.get(k);
+            if (e.flags & kCached) {
+                return e;
+            }
+            e.value = Record();
+            if (primary_.contains(k) && platon::getState(RecordKey(prefix(), k), e.value) != 0) {
+                e.flags |= kExists;
+            }
+            e.flags |= kCached;
+            return e;
+        }
+
+        /**
+         * @brief Cache a new record and add it to every index
+         *
+         */
+        template <typename R>
+        void add(R &&r) {
+            Entry &e = cache_.get(PrimaryKey::key(r));
+            e.value = std::forward<R>(r);
+            e.flags = kCached | kExists | kDirty;
+            primary_.insert(e.key);
+            insertKeys(e.value, std::index_sequence_for<Indexes...>());
+        }
+
+        template <size_t... Is>
+        std::tuple<typename Indexes::KeyType...> indexKeys(const Record &r, std::index_sequence<Is...>) {
+            return std::tuple<typename Indexes::KeyType...>(Extractor<Is>::key(r)...);
+        }
+
+        template <size_t... Is>
+        void insertKeys(const Record &r, std::index_sequence<Is...>) {
+            const Key &k = PrimaryKey::key(r);
+            int expand[] = {0, (std::get<Is>(indexes_).insert(std::make_tuple(Extractor<Is>::key(r), k)), 0)...};
+            (void)expand;
+        }
+
+        template <size_t... Is>
+        void eraseKeys(const Record &r, std::index_sequence<Is...>) {
+            const Key &k = PrimaryKey::key(r);
+            int expand[] = {0, (std::get<Is>(indexes_).erase(std::make_tuple(Extractor<Is>::key(r), k)), 0)...};
+            (void)expand;
+        }
+
+        template <size_t... Is>
+        void updateKeys(const std::tuple<typename Indexes::KeyType...> &keys, const Record &r, std::index_sequence<Is...>) {
+            int expand[] = {0, (updateKey<Is>(std::get<Is>(keys), r), 0)...};
+            (void)expand;
+        }
+
+        /**
+         * @brief Move the record in index N if its index key changed
+         *
+         */
+        template <size_t N>
+        void updateKey(const typename Extractor<N>::KeyType &old, const Record &r) {
+            const typename Extractor<N>::KeyType &current = Extractor<N>::key(r);
+            if (!(old < current) && !(current < old)) {
+                return;
+            }
+            const Key &k = PrimaryKey::key(r);
+            std::get<N>(indexes_).erase(std::make_tuple(old, k));
+            std::get<N>(indexes_).insert(std::make_tuple(current, k));
+        }
+
+        typedef std::tuple<KeyIndex<std::tuple<typename Indexes::KeyType, Key>>...> IndexTrees;
+
+        /**
+         * @brief Records and indexes of the table, shared by the MultiIndex objects of the call
+         *
+         */
+        struct Core {
+            Core() :Core(std::index_sequence_for<Indexes...>()) {}
+
+            template <size_t... Is>
+            explicit Core(std::index_sequence<Is...>) :indexes(indexPrefix(Is)...) {}
+
+            ~Core() {
+                flush();
+            }
+
+            /**
+             * @brief Write the changed records and index pages
+             *
+             */
+            void flush() {
+                StateBatch batch;
+                for (Entry &e : cache) {
+                    if (e.flags & kDeleted) {
+                        batch.del(RecordKey(prefix(), e.key));
+                    } else if (e.flags & kDirty) {
+                        batch.set(RecordKey(prefix(), e.key), e.value);
+                    }
+                    e.flags &= ~(kDirty | kDeleted);
+                }
+                primary.flush(batch);
+                flushIndexes(batch, std::index_sequence_for<Indexes...>());
+                batch.commit();
+            }
+
+            /**
+             * @brief Drop the cached records and index pages without writing them
+             *
+             */
+            void reload() {
+                cache.clear();
+                primary.reset();
+                resetIndexes(std::index_sequence_for<Indexes...>());
+            }
+
+            template <size_t... Is>
+            void flushIndexes(StateBatch &batch, std::index_sequence<Is...>) {
+                int expand[] = {0, (std::get<Is>(indexes).flush(batch), 0)...};
+                (void)expand;
+            }
+
+            template <size_t... Is>
+            void resetIndexes(std::index_sequence<Is...>) {
+                int expand[] = {0, (std::get<Is>(indexes).reset(), 0)...};
+                (void)expand;
+            }
+
+            CacheTable<Key, Record> cache;
+            KeyIndex<Key> primary{prefix()};
+            IndexTrees indexes;
+        };
+
+        std::shared_ptr<Core> core_ = sharedState<Core>();
+        CacheTable<Key, Record> &cache_ = core_->cache;
+        KeyIndex<Key> &primary_ = core_->primary;
+        IndexTrees &indexes_ = core_->indexes;
+    };
+
+    template <const char *Name, typename Record, typename PrimaryKey, typename... Indexes>
+    const std::string MultiIndex<Name, Record, PrimaryKey, Indexes...>::kType = "__multiindex__";
+}
+}
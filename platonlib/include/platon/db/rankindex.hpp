@@ -0,0 +1,160 @@
+//
+// Fenwick tree over the live positions of a list
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace platon {
+namespace db {
+    /**
+     * @brief Counts of live positions kept in a Fenwick tree. rank() and select() cost O(log n),
+     * so a list with deleted positions finds its n-th element without scanning its mark.
+     * The tree is derived from the mark and rebuilt in O(n) when the mark is read.
+     *
+     */
+    class RankIndex {
+    public:
+        /**
+         * @brief Rebuild from the live flags of every position
+         *
+         * @param mark Live flags
+         */
+        void build(const std::vector<bool> &mark) {
+            tree_.assign(mark.size() + 1, 0);
+            for (size_t i = 1; i < tree_.size(); ++i) {
+                tree_[i] += mark[i - 1] ? 1 : 0;
+                size_t parent = i + (i & (0 - i));
+                if (parent < tree_.size()) {
+                    tree_[parent] += tree_[i];
+                }
+            }
+        }
+
+        /**
+         * @brief Append a position
+         *
+         * @param live Whether the position is live
+         */
+        void push(bool live) {
+            if (tree_.empty()) {
+                tree_.push_back(0);
+            }
+            size_t i = tree_.size();
+            // node i covers (i - lowbit(i), i], all but i are already in the tree
+            uint32_t count = (uint32_t)(prefix(i - 1) - prefix(i - (i & (0 - i))));
+            tree_.push_back(count + (live ? 1 : 0));
+        }
+
+        /**
+         * @brief Change the live count of a position
+         *
+         * @param pos Position
+         * @param delta 1 when it became live, -1 when it was deleted
+         */
+        void add(size_t pos, int delta) {
+            for (size_t i = pos + 1; i < tree_.size(); i += i & (0 - i)) {
+                tree_[i] += delta;
+            }
+        }
+
+        /**
+         * @brief Number of live positions before pos
+         *
+         * @param pos Position
+         * @return size_t
+         */
+        size_t rank(size_t pos) const {
+            return prefix(pos);
+        }
+
+        /**
+         * @brief Position of the live element with rank k
+         *
+         * @param k Number of live positions before it
+         * @return size_t size() if fewer than k + 1 positions are live
+         */
+        size_t select(size_t k) const {
+            size_t n = size();
+            size_t step = 1;
+            while (step * 2 <= n) {
+                step *= 2;
+            }
+            size_t pos = 0;
+            size_t rest = k + 1;
+            for (; step != 0; step /= 2) {
+                if (pos + step <= n && tree_[pos + step] < rest) {
+                    pos += step;
+                    rest -= tree_[pos];
+                }
+            }
+            return pos;
+        }
+
+        /**
+         * @brief Position of the deleted element with rank k among the deleted positions
+         *
+         * @param k Number of deleted positions before it
+         * @return size_t size() if fewer than k + 1 positions are deleted
+         */
+        size_t selectHole(size_t k) const {
+            size_t n = size();
+            size_t step = 1;
+            while (step * 2 <= n) {
+                step *= 2;
+            }
+            size_t pos = 0;
+            size_t rest = k + 1;
+            for (; step != 0; step /= 2) {
+                // node pos + step covers step positions
+                if (pos + step <= n && step - tree_[pos + step] < rest) {
+                    pos += step;
+                    rest -= step - tree_[pos];
+                }
+            }
+            return pos;
+        }
+
+        /**
+         * @brief Drop the positions from n on, the nodes up to n only cover positions before n
+         *
+         * @param n New number of positions
+         */
+        void truncate(size_t n) {
+            if (n < size()) {
+                tree_.resize(n + 1);
+            }
+        }
+
+        /**
+         * @brief Number of positions, live or not
+         *
+         */
+        size_t size() const {
+            return tree_.empty() ? 0 : tree_.size() - 1;
+        }
+
+        void clear() {
+            tree_.clear();
+        }
+
+    private:
+        /**
+         * @brief Number of live positions among the first n
+         *
+         */
+        size_t prefix(size_t n) const {
+            size_t count = 0;
+            for (; n != 0; n -= n & (0 - n)) {
+                count += tree_[n];
+            }
+            return count;
+        }
+
+        std::vector<uint32_t> tree_;    // 1-based, node i covers (i - lowbit(i), i]
+    };
+}
+}
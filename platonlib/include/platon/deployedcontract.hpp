@@ -6,6 +6,7 @@
 
 #include "fixedhash.hpp"
 #include "txencode.hpp"
+#include "storage.hpp"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,7 +24,8 @@ extern "C" {
 
 namespace platon {
     /**
-     * @brief Cross-contract call contract
+     * @brief Cross-contract call contract. Buffered state writes are flushed and cached
+     * reads dropped before every call, the callee may read or change the state.
      * 
      */
     class DeployedContract {
@@ -59,6 +61,7 @@ namespace platon {
             RLPStream stream(sizeof...(args) + 2);
             txEncode(stream, kTxType, funcName, args...);
             const bytes& rlpData = stream.out();
+            flushState();
             char *data = ::platonCallString(address_.data(), rlpData.data(), rlpData.size());
             return std::string(data);
         }
@@ -76,6 +79,7 @@ namespace platon {
             RLPStream stream(sizeof...(args) + 2);
             txEncode(stream, kTxType, funcName, args...);
             const bytes& rlpData = stream.out();
+            flushState();
             char *data = ::platonDelegateCallString(address_.data(), rlpData.data(), rlpData.size());
             return std::string(data);
         }
@@ -93,6 +97,7 @@ namespace platon {
             RLPStream stream(sizeof...(args) + 2);
             txEncode(stream, kTxType, funcName, args...);
             const bytes& rlpData = stream.out();
+            flushState();
             return ::platonCallInt64(address_.data(), rlpData.data(), rlpData.size());
         }
 
@@ -110,6 +115,7 @@ namespace platon {
             txEncode(stream, kTxType, funcName, args...);
 
             const bytes& rlpData = stream.out();
+            flushState();
             return ::platonDelegateCallInt64(address_.data(), rlpData.data(), rlpData.size());
         }
 
@@ -126,6 +132,7 @@ namespace platon {
             txEncode(stream, kTxType, funcName, args...);
 
             const bytes& rlpData = stream.out();
+            flushState();
             ::platonCall(address_.data(),rlpData.data(), rlpData.size());
         }
 
@@ -141,6 +148,7 @@ namespace platon {
             RLPStream stream(sizeof...(args) + 2);
             txEncode(stream, kTxType, funcName, args...);
             const bytes& rlpData = stream.out();
+            flushState();
             ::platonDelegateCall(address_.data(), rlpData.data(), rlpData.size());
         }
 
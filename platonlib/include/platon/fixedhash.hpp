@@ -78,7 +78,7 @@ namespace platon {
         /// @returns true if all one-bits in @a _c are set in this object.
         bool contains(FixedHash const& _c) const { return (*this & _c) == _c; }
 
-        const size_t size() const { return N; }
+        size_t size() const { return N; }
     private:
         std::array<byte, N> m_data;
     };
@@ -343,7 +343,7 @@ namespace platon {
         return out;
     }
 
-    static iostream cout;
+    static iostream cout __attribute__((unused));
 
     /// @} consolecppapi
 }
@@ -7,6 +7,9 @@
 #define PLATON_REFLECT_MEMBER_OP( r, OP, elem ) \
   OP t.elem
 
+#define PLATON_REFLECT_MEMBER_VISIT( r, F, elem ) \
+  F( t.elem );
+
 /**
  * @defgroup serialize Serialize API
  * @brief Defines functions to serialize and deserialize object
@@ -21,7 +24,8 @@
  */
 
 /**
- *  Defines serialization and deserialization for a class
+ *  Defines serialization and deserialization for a class, and forEachField(t, f) which calls
+ *  f with every member in serialization order
  *
  *  @brief Defines serialization and deserialization for a class
  *
@@ -36,6 +40,14 @@
  template<typename DS> \
  friend DS& operator >> ( DS& ds, TYPE& t ){ \
     return ds BOOST_PP_SEQ_FOR_EACH( PLATON_REFLECT_MEMBER_OP, >>, MEMBERS );\
+ }\
+ template<typename F> \
+ friend void forEachField( TYPE& t, F&& f ){ \
+    BOOST_PP_SEQ_FOR_EACH( PLATON_REFLECT_MEMBER_VISIT, f, MEMBERS )\
+ }\
+ template<typename F> \
+ friend void forEachField( const TYPE& t, F&& f ){ \
+    BOOST_PP_SEQ_FOR_EACH( PLATON_REFLECT_MEMBER_VISIT, f, MEMBERS )\
  }
 
 /**
@@ -59,5 +71,15 @@
  friend DS& operator >> ( DS& ds, TYPE& t ){ \
     ds >> static_cast<BASE&>(t); \
     return ds BOOST_PP_SEQ_FOR_EACH( PLATON_REFLECT_MEMBER_OP, >>, MEMBERS );\
+ }\
+ template<typename F> \
+ friend void forEachField( TYPE& t, F&& f ){ \
+    forEachField( static_cast<BASE&>(t), f ); \
+    BOOST_PP_SEQ_FOR_EACH( PLATON_REFLECT_MEMBER_VISIT, f, MEMBERS )\
+ }\
+ template<typename F> \
+ friend void forEachField( const TYPE& t, F&& f ){ \
+    forEachField( static_cast<const BASE&>(t), f ); \
+    BOOST_PP_SEQ_FOR_EACH( PLATON_REFLECT_MEMBER_VISIT, f, MEMBERS )\
  }
 ///@} serializecpp
@@ -5,7 +5,10 @@
 
 #include "common.h"
 #include "datastream.h"
+#include <string.h>
 #include <string>
+#include <map>
+#include <memory>
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,12 +16,1017 @@ extern "C" {
     void setState(const uint8_t* key, size_t klen, const uint8_t *value, size_t vlen);
     size_t getStateSize(const uint8_t* key, size_t klen);
     void getState(const uint8_t* key, size_t klen, uint8_t *value, size_t vlen);
+    void sha3(const uint8_t *src, size_t srcLen, uint8_t *dest, size_t destLen);
+#ifdef ENABLE_STATE_EXT
+    size_t getStateValue(const uint8_t* key, size_t klen, uint8_t *value, size_t vlen);
+    size_t getStates(const uint8_t* keys, size_t klen, uint8_t *values, size_t vlen);
+    void setStates(const uint8_t* entries, size_t len);
+#endif
 #ifdef __cplusplus
 }
 #endif
 
 
 namespace platon {
+    /**
+     * @brief Reference to encoded key bytes
+     *
+     */
+    struct StateKey {
+        const char *data;
+        size_t size;
+    };
+
+    /**
+     * @brief Order encoded keys, std::string and StateKey can be compared with each other
+     *
+     */
+    struct StateKeyLess {
+        typedef void is_transparent;
+
+        static int compare(const char *a, size_t alen, const char *b, size_t blen) {
+            int res = memcmp(a, b, alen < blen ? alen : blen);
+            if (res != 0) { return res; }
+            return alen < blen ? -1 : (alen > blen ? 1 : 0);
+        }
+
+        bool operator()(const std::string &a, const std::string &b) const {
+            return a < b;
+        }
+        bool operator()(const std::string &a, const StateKey &b) const {
+            return compare(a.data(), a.size(), b.data, b.size) < 0;
+        }
+        bool operator()(const StateKey &a, const std::string &b) const {
+            return compare(a.data, a.size, b.data(), b.size()) < 0;
+        }
+    };
+
+    /**
+     * @brief View of a string or byte range used as a container key. It is serialized like
+     * std::string, so a lookup by const char *, bytes or a pointer and length finds the
+     * value of the equal std::string key without building one.
+     *
+     */
+    class StringRef {
+    public:
+        StringRef() = default;
+        StringRef(const char *s) :data_(s), size_(strlen(s)) {}
+        StringRef(const char *s, size_t size) :data_(s), size_(size) {}
+        StringRef(const std::string &s) :data_(s.data()), size_(s.size()) {}
+        StringRef(const std::vector<char> &b) :data_(b.data()), size_(b.size()) {}
+        StringRef(const bytes &b) :data_((const char*)b.data()), size_(b.size()) {}
+        StringRef(bytesConstRef b) :data_((const char*)b.data()), size_(b.size()) {}
+
+        const char* data() const { return data_; }
+        size_t size() const { return size_; }
+
+        friend bool operator < (const StringRef &a, const StringRef &b) {
+            return StateKeyLess::compare(a.data_, a.size_, b.data_, b.size_) < 0;
+        }
+        friend bool operator == (const StringRef &a, const StringRef &b) {
+            return a.size_ == b.size_ && memcmp(a.data_, b.data_, a.size_) == 0;
+        }
+    private:
+        const char *data_ = "";
+        size_t size_ = 0;
+    };
+
+    template <typename Stream>
+    inline DataStream<Stream>& operator << (DataStream<Stream> &ds, const StringRef &s) {
+        ds << unsigned_int(s.size());
+        ds.write(s.data(), s.size());
+        return ds;
+    }
+
+    /**
+     * @brief Two strings serialized as one std::string, the key prefix + id without the
+     * temporary string
+     *
+     */
+    class JoinedKey {
+    public:
+        JoinedKey(StringRef first, StringRef second) :first_(first), second_(second) {}
+
+        const StringRef& first() const { return first_; }
+        const StringRef& second() const { return second_; }
+    private:
+        StringRef first_;
+        StringRef second_;
+    };
+
+    template <typename Stream>
+    inline DataStream<Stream>& operator << (DataStream<Stream> &ds, const JoinedKey &key) {
+        ds << unsigned_int(key.first().size() + key.second().size());
+        ds.write(key.first().data(), key.first().size());
+        ds.write(key.second().data(), key.second().size());
+        return ds;
+    }
+
+    /**
+     * @brief Key types that are serialized like std::string and can be looked up by StringRef.
+     * Their operator< has to order bytes as unsigned like StringRef, key indexes are sorted by
+     * it, so std::vector<char> is left out.
+     *
+     */
+    template <typename T>
+    struct IsStringKey : std::false_type {};
+    template <>
+    struct IsStringKey<std::string> : std::true_type {};
+    template <>
+    struct IsStringKey<bytes> : std::true_type {};
+    template <>
+    struct IsStringKey<StringRef> : std::true_type {};
+
+    /**
+     * @brief Byte buffer that keeps up to N bytes inline, larger sizes move to the heap
+     *
+     * @tparam N Inline capacity
+     */
+    template <size_t N>
+    class StateBytes {
+    public:
+        StateBytes() = default;
+        StateBytes(const StateBytes &) = delete;
+        StateBytes& operator=(const StateBytes &) = delete;
+
+        char* data() { return data_; }
+        const char* data() const { return data_; }
+        size_t size() const { return size_; }
+
+        /**
+         * @brief Change the size, the content is kept only while it stays inline
+         *
+         * @param size New size
+         * @return char* Data
+         */
+        char* resize(size_t size) {
+            if (size > N) {
+                heap_.resize(size);
+                data_ = heap_.data();
+            }
+            size_ = size;
+            return data_;
+        }
+    private:
+        char inline_[N];
+        std::vector<char> heap_;
+        char *data_ = inline_;
+        size_t size_ = 0;
+    };
+
+    /**
+     * @brief Inline capacity of encoded keys
+     */
+    const size_t kStateKeyInline = 64;
+    /**
+     * @brief Inline capacity of encoded values read by getState
+     */
+    const size_t kStateValueInline = 256;
+
+    /**
+     * @brief Write buffer of one contract call. While a StateScope is open, setState and
+     * delState only keep the last value of every encoded key, and the buffered values are
+     * written to the blockchain once when the outermost scope is closed.
+     *
+     */
+    class StateBuffer {
+    public:
+        /**
+         * @brief Get the buffer of the current call
+         *
+         * @return StateBuffer&
+         */
+        static StateBuffer& instance() {
+            static StateBuffer buffer;
+            return buffer;
+        }
+
+        /**
+         * @brief Whether writes are buffered
+         *
+         * @return true A scope is open
+         * @return false Writes go to the blockchain directly
+         */
+        bool active() const {
+            return depth_ != 0;
+        }
+
+        /**
+         * @brief Open a scope
+         *
+         */
+        void begin() {
+            ++depth_;
+        }
+
+        /**
+         * @brief Close a scope, the outermost scope flushes the buffer
+         *
+         */
+        void end() {
+            PlatonAssert(depth_ > 0, "state buffer scope not opened");
+            if (depth_ == 1) {
+                // shared container states write into the buffer before it is flushed
+                while (!held_.empty()) {
+                    held_.pop_back();
+                }
+            }
+            if (--depth_ == 0) {
+                flush();
+            }
+        }
+
+        /**
+         * @brief Keep an object alive until the outermost scope ends
+         *
+         * @param object Object, destroyed in reverse order of hold()
+         */
+        void hold(std::shared_ptr<void> object) {
+            held_.push_back(std::move(object));
+        }
+
+        /**
+         * @brief Register a state shared by container objects, see sharedState(). Its changes
+         * are written before a savepoint is opened, and a rollback makes it read the
+         * blockchain again.
+         *
+         * @param object Shared state
+         * @param flush Write the changes of the state
+         * @param reload Drop the cached data of the state without writing it
+         */
+        void share(const std::shared_ptr<void> &object, void (*flush)(void *), void (*reload)(void *)) {
+            shared_.push_back(Shared{object, flush, reload});
+        }
+
+        /**
+         * @brief Record the value of the key, an empty value deletes the key
+         *
+         * @param key Encoded key
+         * @param value Encoded value
+         */
+        void set(std::string &&key, std::string &&value) {
+            if (savepoints_ != 0) {
+                auto iter = dirty_.find(key);
+                if (iter != dirty_.end()) {
+                    undo_.push_back(Undo{key, true, iter->second});
+                } else {
+                    undo_.push_back(Undo{key, false, std::string()});
+                }
+            }
+            dirty_[std::move(key)] = std::move(value);
+        }
+
+        /**
+         * @brief Open a savepoint, it also opens a scope
+         *
+         * @return size_t Mark to roll back to
+         */
+        size_t savepoint() {
+            visitShared([](Shared &shared, void *object) { shared.flush(object); });
+            begin();
+            ++savepoints_;
+            return undo_.size();
+        }
+
+        /**
+         * @brief Restore the buffer to the time the savepoint was opened
+         *
+         * @param mark Mark of the savepoint
+         * @param flushes Number of flushes when the savepoint was opened
+         */
+        void rollback(size_t mark, size_t flushes) {
+            PlatonAssert(flushes == flushes_, "state flushed after the savepoint, can't roll back");
+            // the changes cached by containers since the savepoint are undone with the rest
+            visitShared([](Shared &shared, void *object) { shared.flush(object); });
+            while (undo_.size() > mark) {
+                Undo &undo = undo_.back();
+                if (undo.existed) {
+                    dirty_[undo.key] = std::move(undo.value);
+                } else {
+                    dirty_.erase(undo.key);
+                }
+                undo_.pop_back();
+            }
+            visitShared([](Shared &shared, void *object) { shared.reload(object); });
+        }
+
+        /**
+         * @brief Close a savepoint and keep its writes, they can still be rolled back by an
+         * outer savepoint
+         *
+         */
+        void release() {
+            PlatonAssert(savepoints_ > 0, "savepoint not opened");
+            if (--savepoints_ == 0) {
+                undo_.clear();
+            }
+            end();
+        }
+
+        /**
+         * @brief Number of flushes in the call
+         *
+         * @return size_t
+         */
+        size_t flushes() const {
+            return flushes_;
+        }
+
+        /**
+         * @brief Find the buffered value of the key
+         *
+         * @param key Encoded key
+         * @return const std::string* nullptr if the key is not buffered
+         */
+        const std::string* find(const std::string &key) const {
+            auto iter = dirty_.find(key);
+            return iter != dirty_.end() ? &iter->second : nullptr;
+        }
+
+        /**
+         * @brief Find the buffered value of the key
+         *
+         * @param key Encoded key
+         * @param klen Key length
+         * @return const std::string* nullptr if the key is not buffered
+         */
+        const std::string* find(const char *key, size_t klen) const {
+            auto iter = dirty_.find(StateKey{key, klen});
+            return iter != dirty_.end() ? &iter->second : nullptr;
+        }
+
+        /**
+         * @brief Number of buffered keys
+         *
+         * @return size_t
+         */
+        size_t size() const {
+            return dirty_.size();
+        }
+
+        /**
+         * @brief Write the buffered values to the blockchain
+         *
+         */
+        void flush();
+
+    private:
+        StateBuffer() = default;
+        StateBuffer(const StateBuffer &) = delete;
+        StateBuffer& operator=(const StateBuffer &) = delete;
+
+        /**
+         * @brief Buffered value of a key before a write inside a savepoint
+         */
+        struct Undo {
+            std::string key;
+            bool existed;
+            std::string value;
+        };
+
+        /**
+         * @brief State registered by share()
+         */
+        struct Shared {
+            std::weak_ptr<void> object;
+            void (*flush)(void *);
+            void (*reload)(void *);
+        };
+
+        /**
+         * @brief Call fn with every live shared state, forget the destroyed ones
+         *
+         * @param fn Callable taking Shared& and the state
+         */
+        template <typename Fn>
+        void visitShared(Fn fn) {
+            size_t live = 0;
+            for (size_t i = 0; i < shared_.size(); ++i) {
+                std::shared_ptr<void> object = shared_[i].object.lock();
+                if (!object) {
+                    continue;
+                }
+                fn(shared_[i], object.get());
+                if (live != i) {
+                    shared_[live] = std::move(shared_[i]);
+                }
+                ++live;
+            }
+            shared_.resize(live);
+        }
+
+        std::map<std::string, std::string, StateKeyLess> dirty_;
+        std::vector<Undo> undo_;
+        std::vector<std::shared_ptr<void>> held_;
+        std::vector<Shared> shared_;
+        size_t depth_ = 0;
+        size_t savepoints_ = 0;
+        size_t flushes_ = 0;
+    };
+
+    /**
+     * @brief Buffer the state writes until the scope is destroyed. Contract opens one for
+     * every call, so the writes of a call reach the blockchain once when it returns.
+     *
+     */
+    class StateScope {
+    public:
+        StateScope() {
+            StateBuffer::instance().begin();
+        }
+        StateScope(const StateScope &) = delete;
+        StateScope& operator=(const StateScope &) = delete;
+        ~StateScope() {
+            StateBuffer::instance().end();
+        }
+    };
+
+    /**
+     * @brief State shared by every object of a container type during a call, so the objects
+     * of one type and name load the data once and write it once. Inside a StateScope the state
+     * lives until the outermost scope ends, outside a scope until the last object using it is
+     * destroyed. T writes itself back in its destructor and by flush(), reload() drops what it
+     * cached without writing when a Savepoint is rolled back.
+     *
+     * @tparam T State type, default constructible
+     * @return std::shared_ptr<T>
+     */
+    template <typename T>
+    inline std::shared_ptr<T> sharedState() {
+        static std::weak_ptr<T> slot;
+        std::shared_ptr<T> state = slot.lock();
+        if (!state) {
+            state = std::make_shared<T>();
+            slot = state;
+            StateBuffer &buffer = StateBuffer::instance();
+            buffer.share(state, [](void *object) { static_cast<T*>(object)->flush(); },
+                    [](void *object) { static_cast<T*>(object)->reload(); });
+            if (buffer.active()) {
+                buffer.hold(state);
+            }
+        }
+        return state;
+    }
+
+    /**
+     * @brief Savepoint of the buffered state. Writes after it can be undone with rollback()
+     * and never reach the blockchain; destroying it keeps them. Savepoints nest, and the
+     * writes are buffered even outside a contract. Containers are covered too: their shared
+     * caches are written when the savepoint is opened, and rollback() writes what they
+     * changed since, undoes it and makes them read the blockchain again. Opening a savepoint
+     * keeps the container caches, a rollback drops them, so references, pointers and
+     * iterators into a container taken before rollback() must not be used after it.
+     *
+     * Example:
+     * @code
+     * platon::Savepoint sp;
+     * platon::setState(key, value);
+     * if (!ok) { sp.rollback(); }
+     * @endcode
+     */
+    class Savepoint {
+    public:
+        Savepoint()
+            :flushes_(StateBuffer::instance().flushes()), mark_(StateBuffer::instance().savepoint()) {
+        }
+        Savepoint(const Savepoint &) = delete;
+        Savepoint& operator=(const Savepoint &) = delete;
+        ~Savepoint() {
+            StateBuffer::instance().release();
+        }
+
+        /**
+         * @brief Undo the writes since the savepoint was created
+         *
+         */
+        void rollback() {
+            StateBuffer::instance().rollback(mark_, flushes_);
+        }
+    private:
+        size_t flushes_;
+        size_t mark_;
+    };
+
+    /**
+     * @brief Opt-in read cache of one contract call. Once enabled, the raw value bytes of
+     * every key read from the blockchain are kept for the rest of the call, writes through
+     * setState and delState invalidate the key.
+     *
+     */
+    class StateCache {
+    public:
+        /**
+         * @brief Get the cache of the current call
+         *
+         * @return StateCache&
+         */
+        static StateCache& instance() {
+            static StateCache cache;
+            return cache;
+        }
+
+        /**
+         * @brief Enable or disable the cache, disabling drops the cached values
+         *
+         * @param enabled
+         */
+        void enable(bool enabled = true) {
+            enabled_ = enabled;
+            if (!enabled) {
+                clear();
+            }
+        }
+
+        bool enabled() const {
+            return enabled_;
+        }
+
+        /**
+         * @brief Find the cached value of the key and count the hit or miss
+         *
+         * @param key Encoded key
+         * @param klen Key length
+         * @return const std::string* nullptr if the key is not cached, an empty value means the key does not exist
+         */
+        const std::string* find(const char *key, size_t klen) {
+            if (!enabled_) { return nullptr; }
+            auto iter = values_.find(StateKey{key, klen});
+            if (iter == values_.end()) {
+                ++misses_;
+                return nullptr;
+            }
+            ++hits_;
+            return &iter->second;
+        }
+
+        /**
+         * @brief Remember the value read from the blockchain
+         *
+         * @param key Encoded key
+         * @param klen Key length
+         * @param value Value
+         * @param vlen Value length
+         */
+        void insert(const char *key, size_t klen, const char *value, size_t vlen) {
+            if (!enabled_) { return; }
+            values_[std::string(key, klen)].assign(value, vlen);
+        }
+
+        /**
+         * @brief Invalidate the key
+         *
+         * @param key Encoded key
+         * @param klen Key length
+         */
+        void erase(const char *key, size_t klen) {
+            if (values_.empty()) { return; }
+            auto iter = values_.find(StateKey{key, klen});
+            if (iter != values_.end()) {
+                values_.erase(iter);
+            }
+        }
+
+        /**
+         * @brief Invalidate all keys, the state may have been changed by other code
+         *
+         */
+        void clear() {
+            values_.clear();
+        }
+
+        size_t hits() const {
+            return hits_;
+        }
+
+        size_t misses() const {
+            return misses_;
+        }
+
+    private:
+        StateCache() = default;
+        StateCache(const StateCache &) = delete;
+        StateCache& operator=(const StateCache &) = delete;
+
+        std::map<std::string, std::string, StateKeyLess> values_;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+        bool enabled_ = false;
+    };
+
+    /**
+     * @brief Write the buffered state to the blockchain and drop the cached reads. Called
+     * before code outside the contract runs, it may read or change the state.
+     *
+     */
+    inline void flushState() {
+        StateBuffer::instance().flush();
+        StateCache::instance().clear();
+    }
+
+    /**
+     * @brief Serialize a object into a string
+     *
+     * @tparam T Object type
+     * @param t Object
+     * @return std::string
+     */
+    template <typename T>
+    inline std::string encodeState(const T &t) {
+        std::string res(pack_size(t), '\0');
+        DataStream<char*> stream(&res[0], res.size());
+        stream << t;
+        return res;
+    }
+
+    /**
+     * @brief Serialize a object into a inline buffer
+     *
+     * @tparam N Inline capacity
+     * @tparam T Object type
+     * @param bytes Destination
+     * @param t Object
+     */
+    template <size_t N, typename T>
+    inline void encodeState(StateBytes<N> &bytes, const T &t) {
+        bytes.resize(pack_size(t));
+        DataStream<char*> stream(bytes.data(), bytes.size());
+        stream << t;
+    }
+
+    /**
+     * @brief Fixed length state key, the Keccak-256 digest of a serialized key.
+     * It is written as the 32 raw bytes, without a length prefix.
+     *
+     */
+    class StateDigest {
+    public:
+        static const size_t kSize = 32;
+
+        /**
+         * @brief Construct a new State Digest object
+         *
+         * @tparam KEY Key type
+         * @param key Key, hashed in its serialized form
+         */
+        template <typename KEY>
+        explicit StateDigest(const KEY &key) {
+            StateBytes<kStateKeyInline> bytes;
+            encodeState(bytes, key);
+            ::sha3((const byte*)bytes.data(), bytes.size(), digest_, kSize);
+        }
+
+        const byte* data() const { return digest_; }
+        size_t size() const { return kSize; }
+    private:
+        byte digest_[kSize];
+    };
+
+    template <typename Stream>
+    inline DataStream<Stream>& operator << (DataStream<Stream> &ds, const StateDigest &digest) {
+        ds.write((const char*)digest.data(), digest.size());
+        return ds;
+    }
+
+    /**
+     * @brief Find the value of a encoded key written or read earlier in the call
+     *
+     * @param key Encoded key
+     * @param klen Key length
+     * @return const std::string* nullptr if the blockchain has to be read
+     */
+    inline const std::string* findLocalState(const char *key, size_t klen) {
+        StateBuffer &buffer = StateBuffer::instance();
+        if (buffer.active()) {
+            const std::string *buffered = buffer.find(key, klen);
+            if (buffered != nullptr) {
+                return buffered;
+            }
+        }
+        return StateCache::instance().find(key, klen);
+    }
+
+    /**
+     * @brief Read the value of a encoded key with one host call
+     *
+     * @param key Encoded key
+     * @param klen Key length
+     * @param value Caller-supplied buffer
+     * @param vlen Buffer length
+     * @return size_t Length of the value, only the first vlen bytes are copied when it is larger
+     */
+    inline size_t getStateBytes(const char *key, size_t klen, char *value, size_t vlen) {
+        const std::string *local = findLocalState(key, klen);
+        if (local != nullptr) {
+            memcpy(value, local->data(), local->size() < vlen ? local->size() : vlen);
+            return local->size();
+        }
+#ifdef ENABLE_STATE_EXT
+        size_t len = ::getStateValue((const byte*)key, klen, (byte*)value, vlen);
+#else
+        size_t len = ::getStateSize((const byte*)key, klen);
+        if (len > vlen) {
+            // getState has no bounded form, the whole value is read and its head copied
+            std::string full(len, '\0');
+            ::getState((const byte*)key, klen, (byte*)&full[0], len);
+            memcpy(value, full.data(), vlen);
+            StateCache::instance().insert(key, klen, full.data(), len);
+            return len;
+        }
+        if (len != 0) {
+            ::getState((const byte*)key, klen, (byte*)value, len);
+        }
+#endif
+        if (len <= vlen) {
+            StateCache::instance().insert(key, klen, value, len);
+        }
+        return len;
+    }
+
+    /**
+     * @brief Read the value of a encoded key, the value stays inline when it fits
+     *
+     * @tparam N Inline capacity
+     * @param key Encoded key
+     * @param klen Key length
+     * @param value Destination
+     * @return size_t Length of the value
+     */
+    template <size_t N>
+    inline size_t getStateBytes(const char *key, size_t klen, StateBytes<N> &value) {
+        const std::string *local = findLocalState(key, klen);
+        if (local != nullptr) {
+            memcpy(value.resize(local->size()), local->data(), local->size());
+            return local->size();
+        }
+#ifdef ENABLE_STATE_EXT
+        size_t len = ::getStateValue((const byte*)key, klen, (byte*)value.resize(N), N);
+        if (len > N) {
+            ::getStateValue((const byte*)key, klen, (byte*)value.resize(len), len);
+        }
+#else
+        size_t len = ::getStateSize((const byte*)key, klen);
+        if (len != 0) {
+            ::getState((const byte*)key, klen, (byte*)value.resize(len), len);
+        }
+#endif
+        value.resize(len);
+        StateCache::instance().insert(key, klen, value.data(), len);
+        return len;
+    }
+
+    /**
+     * @brief Append a length prefixed entry to a batch, the length is 4 bytes little endian
+     *
+     * @param batch Batch
+     * @param data Entry
+     * @param len Entry length
+     */
+    inline void appendBatchEntry(std::string &batch, const char *data, size_t len) {
+        char prefix[4] = {(char)(len & 0xff), (char)((len >> 8) & 0xff), (char)((len >> 16) & 0xff), (char)((len >> 24) & 0xff)};
+        batch.append(prefix, sizeof(prefix));
+        batch.append(data, len);
+    }
+
+    /**
+     * @brief Read a length prefixed entry of a batch
+     *
+     * @param pos Position of the entry, moved past it
+     * @param end End of the batch
+     * @param data Entry
+     * @param len Entry length
+     * @return true The entry is complete
+     */
+    inline bool readBatchEntry(const char *&pos, const char *end, const char *&data, size_t &len) {
+        if (end - pos < 4) { return false; }
+        const byte *prefix = (const byte*)pos;
+        len = (size_t)prefix[0] | ((size_t)prefix[1] << 8) | ((size_t)prefix[2] << 16) | ((size_t)prefix[3] << 24);
+        if ((size_t)(end - pos - 4) < len) { return false; }
+        data = pos + 4;
+        pos += 4 + len;
+        return true;
+    }
+
+    /**
+     * @brief Read the values of many encoded keys. With ENABLE_STATE_EXT the keys that are not
+     * buffered or cached are read with one getStates host call, which takes the keys as
+     * length prefixed entries and returns the values in the same layout; otherwise every key
+     * is read on its own.
+     *
+     * @param keys Encoded keys
+     * @param values Values in the order of the keys, empty when the key does not exist
+     */
+    inline void getStatesBytes(const std::vector<std::string> &keys, std::vector<std::string> &values) {
+        values.resize(keys.size());
+        std::vector<size_t> missing;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const std::string *local = findLocalState(keys[i].data(), keys[i].size());
+            if (local != nullptr) {
+                values[i] = *local;
+            } else {
+                missing.push_back(i);
+            }
+        }
+        if (missing.empty()) { return; }
+
+#ifdef ENABLE_STATE_EXT
+        std::string request;
+        for (size_t i : missing) {
+            appendBatchEntry(request, keys[i].data(), keys[i].size());
+        }
+        StateBytes<kStateValueInline> response;
+        size_t len = ::getStates((const byte*)request.data(), request.size(), (byte*)response.resize(kStateValueInline), kStateValueInline);
+        if (len > kStateValueInline) {
+            ::getStates((const byte*)request.data(), request.size(), (byte*)response.resize(len), len);
+        }
+        const char *pos = response.data();
+        const char *end = pos + len;
+        for (size_t i : missing) {
+            const char *data = nullptr;
+            size_t vlen = 0;
+            PlatonAssert(readBatchEntry(pos, end, data, vlen), "getStates response truncated");
+            values[i].assign(data, vlen);
+            StateCache::instance().insert(keys[i].data(), keys[i].size(), data, vlen);
+        }
+#else
+        for (size_t i : missing) {
+            StateBytes<kStateValueInline> value;
+            size_t vlen = getStateBytes(keys[i].data(), keys[i].size(), value);
+            values[i].assign(value.data(), vlen);
+        }
+#endif
+    }
+
+    /**
+     * @brief Write the value of a encoded key, an empty value deletes the key
+     *
+     * @param key Encoded key
+     * @param klen Key length
+     * @param value Encoded value
+     * @param vlen Value length
+     */
+    inline void setStateBytes(const char *key, size_t klen, const char *value, size_t vlen) {
+        StateCache::instance().erase(key, klen);
+        StateBuffer &buffer = StateBuffer::instance();
+        if (buffer.active()) {
+            buffer.set(std::string(key, klen), std::string(value, vlen));
+            return;
+        }
+        ::setState((const byte*)key, klen, (const byte*)value, vlen);
+    }
+
+    /**
+     * @brief Read the serialized value of the key into a caller-supplied buffer
+     *
+     * @tparam KEY Key type
+     * @param key Key
+     * @param value Buffer
+     * @param vlen Buffer length
+     * @return size_t Length of the value, only the first vlen bytes are copied when it is larger
+     */
+    template <typename KEY>
+    inline size_t getStateBytes(const KEY &key, char *value, size_t vlen) {
+        StateBytes<kStateKeyInline> vecKey;
+        encodeState(vecKey, key);
+        return getStateBytes(vecKey.data(), vecKey.size(), value, vlen);
+    }
+
+    /**
+     * @brief Length of the value of a encoded key, without reading the value
+     *
+     * @param key Encoded key
+     * @param klen Key length
+     * @return size_t Length of the value, 0 if the key doesn't exist
+     */
+    inline size_t getStateSizeBytes(const char *key, size_t klen) {
+        const std::string *local = findLocalState(key, klen);
+        if (local != nullptr) {
+            return local->size();
+        }
+        return ::getStateSize((const byte*)key, klen);
+    }
+
+    /**
+     * @brief Whether the key has a value, only the length of the value is read
+     *
+     * @tparam KEY Key type
+     * @param key Key
+     * @return true
+     * @return false
+     */
+    template <typename KEY>
+    inline bool hasState(const KEY &key) {
+        StateBytes<kStateKeyInline> vecKey;
+        encodeState(vecKey, key);
+        return getStateSizeBytes(vecKey.data(), vecKey.size()) != 0;
+    }
+
+    /**
+     * @brief Write the values of many encoded keys. With ENABLE_STATE_EXT they reach the
+     * blockchain in one setStates host call, which takes the key and value of every entry as
+     * length prefixed entries; otherwise every key is written on its own.
+     *
+     * @param entries Encoded keys and values, an empty value deletes the key
+     */
+    inline void writeStatesBytes(const std::vector<std::pair<std::string, std::string>> &entries) {
+        if (entries.empty()) { return; }
+#ifdef ENABLE_STATE_EXT
+        std::string request;
+        for (auto &it : entries) {
+            appendBatchEntry(request, it.first.data(), it.first.size());
+            appendBatchEntry(request, it.second.data(), it.second.size());
+        }
+        ::setStates((const byte*)request.data(), request.size());
+#else
+        for (auto &it : entries) {
+            ::setState((const byte*)it.first.data(), it.first.size(),
+                    (const byte*)it.second.data(), it.second.size());
+        }
+#endif
+    }
+
+    inline void StateBuffer::flush() {
+        if (dirty_.empty()) { return; }
+        ++flushes_;
+        undo_.clear();
+        std::vector<std::pair<std::string, std::string>> entries;
+        entries.reserve(dirty_.size());
+        for (auto &it : dirty_) {
+            entries.emplace_back(it.first, std::move(it.second));
+        }
+        dirty_.clear();
+        writeStatesBytes(entries);
+    }
+
+    /**
+     * @brief Write the values of many encoded keys, buffered while a StateScope is open
+     *
+     * @param entries Encoded keys and values, an empty value deletes the key
+     */
+    inline void setStatesBytes(std::vector<std::pair<std::string, std::string>> &entries) {
+        StateCache &cache = StateCache::instance();
+        for (auto &it : entries) {
+            cache.erase(it.first.data(), it.first.size());
+        }
+        StateBuffer &buffer = StateBuffer::instance();
+        if (buffer.active()) {
+            for (auto &it : entries) {
+                buffer.set(std::move(it.first), std::move(it.second));
+            }
+            return;
+        }
+        writeStatesBytes(entries);
+    }
+
+    /**
+     * @brief Collect state writes and commit them together, containers use it to flush
+     *
+     */
+    class StateBatch {
+    public:
+        StateBatch() = default;
+        StateBatch(const StateBatch &) = delete;
+        StateBatch& operator=(const StateBatch &) = delete;
+
+        /**
+         * @brief Set the State object
+         *
+         * @tparam KEY Key type
+         * @tparam VALUE Value type
+         * @param key Key
+         * @param value Value
+         */
+        template <typename KEY, typename VALUE>
+        void set(const KEY &key, const VALUE &value) {
+            entries_.emplace_back(encodeState(key), encodeState(value));
+        }
+
+        /**
+         * @brief delete State Object
+         *
+         * @tparam KEY Key type
+         * @param key Key
+         */
+        template <typename KEY>
+        void del(const KEY &key) {
+            entries_.emplace_back(encodeState(key), std::string());
+        }
+
+        size_t size() const {
+            return entries_.size();
+        }
+
+        /**
+         * @brief Write the collected entries
+         *
+         */
+        void commit() {
+            setStatesBytes(entries_);
+            entries_.clear();
+        }
+    private:
+        std::vector<std::pair<std::string, std::string>> entries_;
+    };
+
     /**
      * @brief Set the State object
      * 
@@ -29,16 +1037,15 @@ namespace platon {
      */
     template <typename KEY, typename VALUE>
     inline void setState(const KEY &key, const VALUE &value) {
-        std::vector<char> vecKey(pack_size(key));
-        std::vector<char> vecValue(pack_size(value));
-        DataStream<char*> keyStream(vecKey.data(), vecKey.size());
-        DataStream<char*> valueStream(vecValue.data(), vecValue.size());
-        keyStream << key;
-        valueStream << value;
-        ::setState((const byte*)vecKey.data(), vecKey.size(),  (const byte*)vecValue.data(), vecValue.size());
+        StateBytes<kStateKeyInline> vecKey;
+        StateBytes<kStateValueInline> vecValue;
+        encodeState(vecKey, key);
+        encodeState(vecValue, value);
+        setStateBytes(vecKey.data(), vecKey.size(), vecValue.data(), vecValue.size());
     }
     /**
-     * @brief Get the State object
+     * @brief Get the State object. The key is encoded on the stack and values that fit
+     * kStateValueInline are read without heap allocation.
      * 
      * @tparam KEY Key type
      * @tparam VALUE Value type
@@ -48,19 +1055,48 @@ namespace platon {
      */
     template <typename KEY, typename VALUE>
     inline size_t getState(const KEY &key, VALUE &value) {
-        std::vector<char> vecKey(pack_size(key));
-        DataStream<char*> keyStream(vecKey.data(), vecKey.size());
-        keyStream << key;
-        size_t len = ::getStateSize((const byte*)vecKey.data(), vecKey.size());
+        StateBytes<kStateKeyInline> vecKey;
+        encodeState(vecKey, key);
+        StateBytes<kStateValueInline> vecValue;
+        size_t len = getStateBytes(vecKey.data(), vecKey.size(), vecValue);
         if (len == 0){ return 0; }
-        std::vector<char> vecValue(len);
-        ::getState((const byte*)vecKey.data(), vecKey.size(), (byte*)vecValue.data(), vecValue.size());
 
-        DataStream<char*> valueStream(vecValue.data(), vecValue.size());
+        DataStream<const char*> valueStream(vecValue.data(), vecValue.size());
         valueStream >> value;
         return len;
     }
 
+    /**
+     * @brief Get many State objects at once
+     *
+     * @tparam KEY Key type
+     * @tparam VALUE Value type
+     * @param keys Keys
+     * @param values Values in the order of the keys, keys that do not exist get a default value
+     * @return size_t Number of keys that exist
+     */
+    template <typename KEY, typename VALUE>
+    inline size_t getStates(const std::vector<KEY> &keys, std::vector<VALUE> &values) {
+        std::vector<std::string> vecKeys;
+        vecKeys.reserve(keys.size());
+        for (auto &key : keys) {
+            vecKeys.push_back(encodeState(key));
+        }
+        std::vector<std::string> vecValues;
+        getStatesBytes(vecKeys, vecValues);
+
+        size_t found = 0;
+        values.clear();
+        values.resize(keys.size());
+        for (size_t i = 0; i < vecValues.size(); ++i) {
+            if (vecValues[i].empty()) { continue; }
+            DataStream<const char*> valueStream(vecValues[i].data(), vecValues[i].size());
+            valueStream >> values[i];
+            ++found;
+        }
+        return found;
+    }
+
     /**
      * @brief delete State Object
      * 
@@ -69,11 +1105,66 @@ namespace platon {
      */
     template <typename KEY>
     inline void delState(const KEY &key) {
-        byte del = 0;
-        std::vector<char> vecKey(pack_size(key));
-        DataStream<char*> keyStream(vecKey.data(), vecKey.size());
-        keyStream << key;
-        ::setState((const byte*)vecKey.data(), vecKey.size(),  (const byte*)&del, 0);
+        char del = 0;
+        StateBytes<kStateKeyInline> vecKey;
+        encodeState(vecKey, key);
+        setStateBytes(vecKey.data(), vecKey.size(), &del, 0);
     }
 
+    /**
+     * @brief Compact namespace ID of a container name, 0 keeps the name itself as key prefix.
+     * Assign an ID with PLATON_STATE_ID.
+     *
+     * @tparam Name Container name
+     */
+    template <const char *Name>
+    struct StateNamespace {
+        static const uint32_t kId = 0;
+    };
+
+    /**
+     * @brief Owner of a namespace ID, specialized once per ID by PLATON_STATE_ID
+     *
+     * @tparam Id Namespace ID
+     */
+    template <uint32_t Id>
+    struct StateNamespaceOwner;
+
+    /**
+     * @brief Key prefix of a container, built once per container type
+     *
+     * @tparam Name Container name
+     * @param type Container type name, used when Name has no ID
+     * @param tag Container type tag, used with the ID
+     * @return std::string The type and name, or the tag and the big endian ID
+     */
+    template <const char *Name>
+    inline std::string statePrefix(const std::string &type, char tag) {
+        const uint32_t id = StateNamespace<Name>::kId;
+        if (id == 0) {
+            return type + Name;
+        }
+        char prefix[5] = {tag, (char)(id >> 24), (char)(id >> 16), (char)(id >> 8), (char)id};
+        return std::string(prefix, sizeof(prefix));
+    }
 }
+
+/**
+ * @brief Store the containers named NAME under a 4 byte namespace ID instead of their name.
+ * Use once per name at global scope, a name or ID used twice fails to compile.
+ *
+ * Example:
+ * @code
+ * char balances[] = "balances";
+ * PLATON_STATE_ID(balances, 1)
+ * platon::db::Map<balances, std::string, uint64_t> map;
+ * @endcode
+ */
+#define PLATON_STATE_ID(NAME, ID) \
+    namespace platon { \
+        template <> struct StateNamespaceOwner<ID> { static const char *name() { return NAME; } }; \
+        template <> struct StateNamespace<NAME> { \
+            static_assert(ID != 0, "namespace ID 0 is reserved"); \
+            static const uint32_t kId = ID; \
+        }; \
+    }
@@ -41,19 +41,29 @@ namespace platon {
             init();
         }
 
+        /**
+         * @brief Construct a new Storage Type object, the default is moved in
+         *
+         * @param d Element
+         */
+        StorageType(T&& d):default_(std::move(d)) {
+            init();
+        }
+
         StorageType(const StorageType<Name, T>  &) = delete;
         StorageType(const StorageType<Name, T> &&) = delete;
         /**
-         * @brief Destroy the Storage Type object. Refresh to blockchain
+         * @brief Destroy the Storage Type object. The value is shared by the objects of the
+         * same name in the call and refreshed to blockchain once, see sharedState().
          * 
          */
         ~StorageType() {
-            flush();
         }
 
 
 
-        T& operator=(const T& t) { t_ = t; }
+        T& operator=(const T& t) { t_ = t; return t_; }
+        T& operator=(T&& t) { t_ = std::move(t); return t_; }
 
         template<typename P>
         bool operator==(const P &t) const { return t_ == t; }
@@ -106,20 +116,60 @@ namespace platon {
          * 
          */
         void init() {
+            if (core_->loaded) {
+                return;
+            }
+            core_->loaded = true;
+            core_->initial = default_;
             if (getState(name_, t_) == 0) {
-                t_ = default_;
+                t_ = std::move(default_);
             }
         }
         /**
-         * @brief Refresh to blockchain
-         * 
+         * @brief Key of the value, the name or its namespace ID
+         *
+         * @return const std::string&
          */
-        void flush() {
-            setState(name_, t_);
+        static const std::string& prefix() {
+            static const std::string prefix = statePrefix<Name>(std::string(), 's');
+            return prefix;
         }
+
+        /**
+         * @brief Value shared by the objects of the call, refreshed to blockchain when destroyed
+         *
+         */
+        struct Core {
+            ~Core() {
+                flush();
+            }
+
+            void flush() {
+                if (loaded) {
+                    setState(prefix(), t);
+                }
+            }
+
+            /**
+             * @brief Read the value again without writing it, the default of the first load
+             * stands in for a missing value
+             *
+             */
+            void reload() {
+                if (loaded && getState(prefix(), t) == 0) {
+                    t = initial;
+                }
+            }
+
+            T t = T();
+            T initial = T();
+            bool loaded = false;
+        };
+
         T default_;
-        const std::string name_ = Name;
-        T t_;
+        const std::string &name_ = prefix();
+        std::shared_ptr<Core> core_ = sharedState<Core>();
+        T &t_ = core_->t;
     };
 
     template <const char *name>
@@ -0,0 +1,32 @@
+//
+// Host calls of loading many keys one by one and with getStates.
+//
+
+#include "host.hpp"
+#include "platon/storage.hpp"
+
+int main() {
+    const size_t count = 10000;
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < count; ++i) {
+        keys.push_back(i);
+        platon::setState(i, "value" + std::to_string(i));
+    }
+
+    host::counter() = host::Counter();
+    std::vector<std::string> single(count);
+    for (size_t i = 0; i < count; ++i) {
+        platon::getState(keys[i], single[i]);
+    }
+    host::Counter singleCounter = host::counter();
+
+    host::counter() = host::Counter();
+    std::vector<std::string> batch;
+    size_t found = platon::getStates(keys, batch);
+    host::Counter batchCounter = host::counter();
+
+    PlatonAssert(found == count && batch == single, "batch read mismatch");
+    printf("single     host calls %6zu\n", singleCounter.calls());
+    printf("getStates  host calls %6zu\n", batchCounter.calls());
+    return 0;
+}
@@ -0,0 +1,46 @@
+//
+// Host calls of flushing 10k dirty container entries. Build with and without
+// ENABLE_STATE_EXT to compare batched setStates with per-key setState.
+//
+
+#include "host.hpp"
+#include "platon/db/map.hpp"
+#include "platon/db/array.hpp"
+
+char batchMapName[] = "batchmap";
+char batchArrayName[] = "batcharray";
+
+const size_t kEntries = 10000;
+
+typedef platon::db::Map<batchMapName, uint64_t, std::string, platon::db::MapType::NoTraverse> BatchMap;
+typedef platon::db::Array<batchArrayName, uint64_t, kEntries> BatchArray;
+
+int main() {
+    host::reset();
+    {
+        BatchMap map;
+        for (uint64_t i = 0; i < kEntries; ++i) {
+            map.insert(i, "value" + std::to_string(i));
+        }
+    }
+    host::Counter mapCounter = host::counter();
+
+    host::reset();
+    {
+        BatchArray array;
+        for (uint64_t i = 0; i < kEntries; ++i) {
+            array[i] = i;
+        }
+        host::counter() = host::Counter();
+    }
+    host::Counter arrayCounter = host::counter();
+
+#ifdef ENABLE_STATE_EXT
+    printf("setStates\n");
+#else
+    printf("setState per key\n");
+#endif
+    printf("map flush    host calls %6zu  bytes written %8zu\n", mapCounter.calls(), mapCounter.bytesWritten);
+    printf("array flush  host calls %6zu  bytes written %8zu\n", arrayCounter.calls(), arrayCounter.bytesWritten);
+    return 0;
+}
@@ -0,0 +1,96 @@
+//
+// Bytes of values copied by container writes and loads, copying and moving overloads.
+//
+
+#include "host.hpp"
+#include "platon/storagetype.hpp"
+#include "platon/db/map.hpp"
+#include "platon/db/list.hpp"
+#include "platon/db/array.hpp"
+
+size_t copied = 0;
+
+/**
+ * @brief Large value that counts the bytes of its copies
+ *
+ */
+struct Blob {
+    Blob() = default;
+    explicit Blob(size_t size) :data(size, 'b') {}
+    Blob(const Blob &b) :data(b.data) { copied += data.size(); }
+    Blob(Blob &&b) = default;
+    Blob& operator=(const Blob &b) { data = b.data; copied += data.size(); return *this; }
+    Blob& operator=(Blob &&b) = default;
+
+    std::vector<char> data;
+    PLATON_SERIALIZE(Blob, (data))
+};
+
+char mapName[] = "copymap";
+char listName[] = "copylist";
+char arrayName[] = "copyarray";
+char storageName[] = "copystorage";
+
+const size_t kValues = 100;
+const size_t kSize = 4096;
+
+size_t copyWrites() {
+    copied = 0;
+    platon::db::Map<mapName, int, Blob> map;
+    platon::db::List<listName, Blob> list;
+    platon::db::Array<arrayName, Blob, kValues> array;
+    for (size_t i = 0; i < kValues; ++i) {
+        Blob v(kSize);
+        map.insert((int)i, v);
+        list.push(v);
+        array[i];
+        array.setConst(i, v);
+    }
+    platon::StorageType<storageName, Blob> storage;
+    Blob v(kSize);
+    storage = v;
+    return copied;
+}
+
+size_t moveWrites() {
+    copied = 0;
+    platon::db::Map<mapName, int, Blob> map;
+    platon::db::List<listName, Blob> list;
+    platon::db::Array<arrayName, Blob, kValues> array;
+    for (size_t i = 0; i < kValues; ++i) {
+        map.insert((int)i, Blob(kSize));
+        list.emplace(kSize);
+        array[i];
+        array.setConst(i, Blob(kSize));
+    }
+    platon::StorageType<storageName, Blob> storage;
+    storage = Blob(kSize);
+    return copied;
+}
+
+size_t loads() {
+    copied = 0;
+    platon::db::Map<mapName, int, Blob> map;
+    platon::db::List<listName, Blob> list;
+    platon::db::Array<arrayName, Blob, kValues> array;
+    for (size_t i = 0; i < kValues; ++i) {
+        map.get((int)i);
+        list.get(i);
+        array.at(i);
+    }
+    return copied;
+}
+
+int main() {
+    host::reset();
+    size_t copy = copyWrites();
+    host::reset();
+    size_t move = moveWrites();
+    size_t load = loads();
+
+    printf("values %zu x %zu bytes per container\n", kValues, kSize);
+    printf("const& writes  bytes copied %10zu\n", copy);
+    printf("rvalue writes  bytes copied %10zu\n", move);
+    printf("loads          bytes copied %10zu\n", load);
+    return 0;
+}
@@ -0,0 +1,160 @@
+//
+// In-memory stand-in for the blockchain imports used by the native benchmarks.
+// Every state import is counted, so a benchmark can compare the host calls of two runs.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+typedef __int128 int128_t;
+typedef unsigned __int128 uint128_t;
+
+namespace host {
+    struct Counter {
+        size_t setState = 0;
+        size_t getStateSize = 0;
+        size_t getState = 0;
+        size_t getStateValue = 0;
+        size_t getStates = 0;
+        size_t setStates = 0;
+        size_t bytesWritten = 0;
+
+        size_t calls() const {
+            return setState + getStateSize + getState + getStateValue + getStates + setStates;
+        }
+
+        size_t writes() const {
+            return setState + setStates;
+        }
+    };
+
+    inline std::map<std::string, std::string>& db() {
+        static std::map<std::string, std::string> db;
+        return db;
+    }
+
+    inline size_t readLength(const uint8_t *data) {
+        return data[0] | (data[1] << 8) | (data[2] << 16) | ((size_t)data[3] << 24);
+    }
+
+    inline Counter& counter() {
+        static Counter counter;
+        return counter;
+    }
+
+    /**
+     * @brief Drop the state and the counters
+     *
+     */
+    inline void reset() {
+        db().clear();
+        counter() = Counter();
+    }
+}
+
+extern "C" {
+    void prints(const char *cstr) { fputs(cstr, stdout); }
+    void prints_l(const char *cstr, uint32_t len) { fwrite(cstr, 1, len, stdout); }
+    void printi(int64_t value) { printf("%lld", (long long)value); }
+    void printui(uint64_t value) { printf("%llu", (unsigned long long)value); }
+    void printi128(const int128_t *value) { printf("%lld", (long long)*value); }
+    void printui128(const uint128_t *value) { printf("%llu", (unsigned long long)*value); }
+    void printsf(float value) { printf("%f", value); }
+    void printdf(double value) { printf("%f", value); }
+    void printqf(const long double *value) { printf("%Lf", *value); }
+    void printhex(const void *data, uint32_t datalen) {
+        for (uint32_t i = 0; i < datalen; ++i) { printf("%02x", ((const uint8_t*)data)[i]); }
+    }
+
+    /**
+     * @brief Stand-in for the Keccak-256 import, four FNV-1a lanes. Deterministic, not cryptographic.
+     *
+     */
+    void sha3(const uint8_t *src, size_t srcLen, uint8_t *dest, size_t destLen) {
+        for (size_t lane = 0; lane < destLen / 8; ++lane) {
+            uint64_t hash = 14695981039346656037ULL ^ lane;
+            for (size_t i = 0; i < srcLen; ++i) {
+                hash = (hash ^ src[i]) * 1099511628211ULL;
+            }
+            memcpy(dest + lane * 8, &hash, 8);
+        }
+    }
+
+    void setState(const uint8_t *key, size_t klen, const uint8_t *value, size_t vlen) {
+        host::counter().setState++;
+        host::counter().bytesWritten += klen + vlen;
+        std::string k((const char*)key, klen);
+        if (vlen == 0) {
+            host::db().erase(k);
+        } else {
+            host::db()[k] = std::string((const char*)value, vlen);
+        }
+    }
+
+    size_t getStateSize(const uint8_t *key, size_t klen) {
+        host::counter().getStateSize++;
+        auto iter = host::db().find(std::string((const char*)key, klen));
+        return iter == host::db().end() ? 0 : iter->second.size();
+    }
+
+    void getState(const uint8_t *key, size_t klen, uint8_t *value, size_t vlen) {
+        host::counter().getState++;
+        auto iter = host::db().find(std::string((const char*)key, klen));
+        if (iter != host::db().end()) {
+            memcpy(value, iter->second.data(), vlen < iter->second.size() ? vlen : iter->second.size());
+        }
+    }
+
+    size_t getStateValue(const uint8_t *key, size_t klen, uint8_t *value, size_t vlen) {
+        host::counter().getStateValue++;
+        auto iter = host::db().find(std::string((const char*)key, klen));
+        if (iter == host::db().end()) {
+            return 0;
+        }
+        memcpy(value, iter->second.data(), vlen < iter->second.size() ? vlen : iter->second.size());
+        return iter->second.size();
+    }
+
+    size_t getStates(const uint8_t *keys, size_t klen, uint8_t *values, size_t vlen) {
+        host::counter().getStates++;
+        std::string response;
+        size_t pos = 0;
+        while (pos + 4 <= klen) {
+            size_t len = host::readLength(keys + pos);
+            auto iter = host::db().find(std::string((const char*)keys + pos + 4, len));
+            std::string value = iter == host::db().end() ? std::string() : iter->second;
+            char prefix[4] = {(char)(value.size() & 0xff), (char)((value.size() >> 8) & 0xff),
+                              (char)((value.size() >> 16) & 0xff), (char)((value.size() >> 24) & 0xff)};
+            response.append(prefix, sizeof(prefix));
+            response.append(value);
+            pos += 4 + len;
+        }
+        if (response.size() <= vlen) {
+            memcpy(values, response.data(), response.size());
+        }
+        return response.size();
+    }
+
+    void setStates(const uint8_t *entries, size_t len) {
+        host::counter().setStates++;
+        host::counter().bytesWritten += len;
+        size_t pos = 0;
+        while (pos + 4 <= len) {
+            size_t klen = host::readLength(entries + pos);
+            std::string key((const char*)entries + pos + 4, klen);
+            pos += 4 + klen;
+            size_t vlen = host::readLength(entries + pos);
+            if (vlen == 0) {
+                host::db().erase(key);
+            } else {
+                host::db()[key] = std::string((const char*)entries + pos + 4, vlen);
+            }
+            pos += 4 + vlen;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+//
+// Bytes read and written by one insert into a 100k-key Traverse map, compared with
+// the single std::set blob the key set used to be stored in.
+//
+
+#include "host.hpp"
+#include "platon/db/map.hpp"
+
+char indexMapName[] = "indexmap";
+
+const uint64_t kKeys = 100000;
+
+typedef platon::db::Map<indexMapName, uint64_t, uint64_t> IndexMap;
+
+int main() {
+    host::reset();
+    std::set<uint64_t> keys;
+    for (uint64_t i = 0; i < kKeys; ++i) {
+        keys.insert(i * 2);
+    }
+    platon::setState(IndexMap::kType + indexMapName, keys);
+    size_t blob = platon::pack_size(keys);
+
+    host::counter() = host::Counter();
+    {
+        IndexMap map;
+        map.size();
+    }
+    host::Counter migrate = host::counter();
+
+    host::counter() = host::Counter();
+    {
+        IndexMap map;
+        map.insert(kKeys + 1, 1);
+        map.del(kKeys);
+    }
+    host::Counter update = host::counter();
+
+    printf("key set blob            %8zu bytes, read and rewritten by every call\n", blob);
+    printf("migration               %8zu host calls  %8zu bytes written\n", migrate.calls(), migrate.bytesWritten);
+    printf("insert + delete         %8zu host calls  %8zu bytes written\n", update.calls(), update.bytesWritten);
+    return 0;
+}
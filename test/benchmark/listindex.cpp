@@ -0,0 +1,86 @@
+//
+// Time of one indexed List access at growing sizes. Every other element is deleted, so
+// the index has to skip tombstones; the rank index keeps the cost flat. Then the host
+// calls of a full traversal by ConstIterator, by range-for and by scan().
+//
+
+#include <chrono>
+#include "host.hpp"
+#include "platon/db/list.hpp"
+
+char indexListName[] = "indexlist";
+
+typedef platon::db::List<indexListName, uint32_t> IndexList;
+
+const size_t kAccesses = 10000;
+
+/**
+ * @brief Nanoseconds of one getConst() in a list of n live elements
+ *
+ * @param n Number of live elements
+ */
+double access(size_t n) {
+    host::reset();
+    {
+        IndexList list;
+        for (uint32_t i = 0; i < n * 2; ++i) {
+            list.push(i);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            list.del(i);
+        }
+    }
+    IndexList list;
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < kAccesses; ++i) {
+        sum += list.getConst((i * 7919) % n);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (sum == 0) {
+        printf("no elements read\n");
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / kAccesses;
+}
+
+/**
+ * @brief Host calls of reading every element of the list left by access()
+ *
+ */
+void traverse() {
+    uint64_t sum = 0;
+    host::counter() = host::Counter();
+    {
+        IndexList list;
+        for (IndexList::ConstIterator iter = list.cbegin(); iter != list.cend(); ++iter) {
+            sum += *iter;
+        }
+    }
+    host::Counter iterator = host::counter();
+    host::counter() = host::Counter();
+    {
+        IndexList list;
+        for (uint32_t &v : list) {
+            sum += v;
+        }
+    }
+    host::Counter rangeFor = host::counter();
+    host::counter() = host::Counter();
+    {
+        IndexList list;
+        for (uint32_t v : list.scan()) {
+            sum -= 2 * v;
+        }
+    }
+    host::Counter cursor = host::counter();
+    printf("traversal  iterator %8zu host calls  range-for %6zu host calls  scan() %6zu host calls%s\n",
+           iterator.calls(), rangeFor.calls(), cursor.calls(), sum == 0 ? "" : "  mismatch");
+}
+
+int main() {
+    for (size_t n = 1000; n <= 100000; n *= 10) {
+        printf("%7zu live elements  %8.0f ns per indexed access\n", n, access(n));
+    }
+    traverse();
+    return 0;
+}
@@ -0,0 +1,52 @@
+//
+// Host reads of a call that reads the same keys repeatedly, with and without the read cache.
+//
+
+#include "host.hpp"
+#include "platon/storage.hpp"
+
+/**
+ * @brief Read pattern of the MPC contract: the partner list is checked and read again,
+ * the result of a task is loaded by several getters
+ *
+ * @param tasks Number of tasks handled in the call
+ */
+void call(size_t tasks) {
+    std::string parties;
+    for (size_t i = 0; i < tasks; ++i) {
+        std::string result;
+        platon::getState(std::string("__MPC____PARTIES__"), parties);
+        platon::getState("__MPC___MAP_RESULT_" + std::to_string(i), result);
+        platon::getState(std::string("__MPC____PARTIES__"), parties);
+        platon::getState("__MPC___MAP_RESULT_" + std::to_string(i), result);
+        platon::getState("__MPC___MAP_RESULT_" + std::to_string(i), result);
+    }
+}
+
+void prepare(size_t tasks) {
+    host::reset();
+    platon::setState(std::string("__MPC____PARTIES__"), std::string("0xa0b21d5bcc6af4dda0579174941160b9eecb6918&0xa0b21d5bcc6af4dda0579174941160b9eecb6919"));
+    for (size_t i = 0; i < tasks; ++i) {
+        platon::setState("__MPC___MAP_RESULT_" + std::to_string(i), std::string("1&result"));
+    }
+    host::counter() = host::Counter();
+}
+
+int main() {
+    const size_t tasks = 100;
+    platon::StateCache &cache = platon::StateCache::instance();
+
+    prepare(tasks);
+    call(tasks);
+    host::Counter uncached = host::counter();
+
+    prepare(tasks);
+    cache.enable();
+    call(tasks);
+    host::Counter cached = host::counter();
+
+    printf("uncached   host calls %6zu\n", uncached.calls());
+    printf("cached     host calls %6zu  hits %6zu  misses %6zu\n", cached.calls(), cache.hits(), cache.misses());
+    printf("host reads reduced %.1fx\n", (double)uncached.calls() / (double)cached.calls());
+    return 0;
+}
@@ -0,0 +1,60 @@
+//
+// Host writes of one contract call with and without the state write buffer.
+//
+
+#include "host.hpp"
+#include "platon/storagetype.hpp"
+#include "platon/db/map.hpp"
+
+char benchMapName[] = "benchmap";
+char benchCounterName[] = "benchcounter";
+
+typedef platon::db::Map<benchMapName, std::string, uint64_t> BenchMap;
+typedef platon::StorageType<benchCounterName, uint64_t> BenchCounter;
+
+/**
+ * @brief A call that touches the same keys through containers and setState several times
+ *
+ * @param rounds Number of helper invocations in the call
+ */
+void call(size_t rounds) {
+    for (size_t i = 0; i < rounds; ++i) {
+        {
+            BenchMap map;
+            map["balance" + std::to_string(i % 8)] += i;
+            map["total"] += i;
+        }
+        {
+            BenchCounter counter(0);
+            ++counter;
+        }
+        platon::setState(std::string("lastRound"), i);
+        platon::setState(std::string("status"), std::string("running"));
+    }
+    platon::setState(std::string("status"), std::string("done"));
+}
+
+void report(const char *name, const host::Counter &counter) {
+    printf("%-10s host calls %6zu  writes %6zu  bytes written %8zu\n",
+            name, counter.calls(), counter.writes(), counter.bytesWritten);
+}
+
+int main() {
+    const size_t rounds = 200;
+
+    host::reset();
+    call(rounds);
+    host::Counter direct = host::counter();
+
+    host::reset();
+    {
+        platon::StateScope scope;
+        call(rounds);
+    }
+    host::Counter buffered = host::counter();
+
+    report("direct", direct);
+    report("buffered", buffered);
+    printf("host writes reduced %.1fx\n", (double)direct.writes() / (double)buffered.writes());
+    return 0;
+}
@@ -0,0 +1,287 @@
+//
+// Host calls of the state layer, counted by the stand-in host of host.hpp. Built with and
+// without ENABLE_STATE_EXT, the batched imports have to match the fallback.
+//
+
+#include "../benchmark/host.hpp"
+#include "platon/storage.hpp"
+#include "platon/db/map.hpp"
+#include "platon/db/list.hpp"
+#include "../unittest.hpp"
+
+char callMapName[] = "callmap";
+char callListName[] = "calllist";
+
+char callBloomName[] = "callbloom";
+char clearMapName[] = "clearmap";
+char clearListName[] = "clearlist";
+char clearValuesName[] = "clearvalues";
+
+typedef platon::db::Map<callMapName, int, int> CallMap;
+typedef platon::db::Map<callBloomName, int, int, platon::db::MapType::NoTraverse,
+        platon::db::MapKey::Plain, 1024> CallBloom;
+typedef platon::db::List<callListName, int> CallList;
+typedef platon::db::Map<clearMapName, std::string, std::string> ClearMap;
+typedef platon::db::List<clearListName, std::string> ClearList;
+typedef platon::db::List<clearValuesName, std::string, platon::db::ListIndex::Value> ClearValues;
+
+TEST_CASE(hostcalls, getstates) {
+    host::reset();
+    std::vector<std::string> keys;
+    for (int i = 0; i < 10; ++i) {
+        keys.push_back("getstates" + std::to_string(i));
+        platon::setState(keys.back(), i);
+    }
+    keys.push_back("getstatesmissing");
+    host::counter() = host::Counter();
+    std::vector<int> values;
+    ASSERT_EQ(platon::getStates(keys, values), 10);
+    ASSERT_EQ(values.size(), 11);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(values[i], i);
+    }
+    ASSERT_EQ(values[10], 0);
+#ifdef ENABLE_STATE_EXT
+    ASSERT_EQ(host::counter().getStates, 1);
+    ASSERT_EQ(host::counter().calls(), 1);
+#else
+    ASSERT_EQ(host::counter().getStates, 0);
+    ASSERT_EQ(host::counter().getStateSize, 11);
+    ASSERT_EQ(host::counter().getState, 10);
+#endif
+}
+
+TEST_CASE(hostcalls, setstates) {
+    host::reset();
+    platon::setState(std::string("setstatesdel"), 1);
+    host::counter() = host::Counter();
+    platon::StateBatch batch;
+    for (int i = 0; i < 10; ++i) {
+        batch.set("setstates" + std::to_string(i), i);
+    }
+    batch.del(std::string("setstatesdel"));
+    batch.commit();
+#ifdef ENABLE_STATE_EXT
+    ASSERT_EQ(host::counter().setStates, 1);
+    ASSERT_EQ(host::counter().setState, 0);
+#else
+    ASSERT_EQ(host::counter().setStates, 0);
+    ASSERT_EQ(host::counter().setState, 11);
+#endif
+    ASSERT_EQ(host::db().size(), 10);
+    int value = 0;
+    ASSERT(platon::getState(std::string("setstates9"), value) != 0);
+    ASSERT_EQ(value, 9);
+    ASSERT(!platon::hasState(std::string("setstatesdel")));
+}
+
+TEST_CASE(hostcalls, buffer) {
+    host::reset();
+    {
+        platon::StateScope scope;
+        for (int i = 0; i < 10; ++i) {
+            platon::setState(std::string("buffer"), i);
+        }
+        ASSERT_EQ(host::counter().calls(), 0);
+    }
+    ASSERT_EQ(host::counter().writes(), 1);
+    int value = 0;
+    platon::getState(std::string("buffer"), value);
+    ASSERT_EQ(value, 9);
+}
+
+TEST_CASE(hostcalls, bytes) {
+    host::reset();
+    std::string large(1000, 'a');
+    platon::setState(std::string("bytes"), large);
+    host::counter() = host::Counter();
+    char buf[8];
+    ASSERT_EQ(platon::getStateBytes(std::string("bytes"), buf, sizeof(buf)), platon::pack_size(large));
+    ASSERT_EQ(std::string(buf, sizeof(buf)), platon::encodeState(large).substr(0, sizeof(buf)));
+#ifdef ENABLE_STATE_EXT
+    ASSERT_EQ(host::counter().getStateValue, 1);
+    ASSERT_EQ(host::counter().calls(), 1);
+#else
+    ASSERT_EQ(host::counter().getStateSize, 1);
+    ASSERT_EQ(host::counter().getState, 1);
+#endif
+}
+
+TEST_CASE(hostcalls, reflush) {
+    host::reset();
+    CallMap map;
+    for (int i = 0; i < 10; ++i) {
+        map[i] = i;
+    }
+    map.del(3);
+    map.flush();
+    host::counter() = host::Counter();
+    map.flush();
+    ASSERT_EQ(host::counter().calls(), 0);
+    map[4] += 1;
+    map.flush();
+    ASSERT_EQ(host::counter().writes(), 1);
+}
+
+TEST_CASE(hostcalls, bloom) {
+    host::reset();
+    {
+        CallBloom map;
+        map[1] = 1;
+        host::counter() = host::Counter();
+        // no filter yet, a miss reads the blockchain
+        ASSERT(!map.contains(2));
+        ASSERT(host::counter().calls() > 0);
+        map.buildBloom({1});
+    }
+    CallBloom map;
+    ASSERT(map.contains(1));
+    host::counter() = host::Counter();
+    for (int i = 2; i < 10; ++i) {
+        ASSERT(!map.contains(i * 1000));
+    }
+    ASSERT_EQ(host::counter().calls(), 0);
+}
+
+TEST_CASE(hostcalls, list) {
+    host::reset();
+    const size_t n = 200;
+    {
+        CallList list;
+        for (size_t i = 0; i < n; ++i) {
+            list.push((int)i);
+        }
+    }
+    // the list is opened before counting, so only the element reads are counted. A batch
+    // takes one getStates, and a second one when the values outgrow the inline buffer.
+#ifdef ENABLE_STATE_EXT
+    size_t batches = (n + CallList::kIteratorBatch - 1) / CallList::kIteratorBatch;
+#endif
+    int sum = 0;
+    {
+        CallList list;
+        host::counter() = host::Counter();
+        for (int v : list.scan(CallList::kIteratorBatch)) {
+            sum += v;
+        }
+#ifdef ENABLE_STATE_EXT
+        ASSERT(host::counter().getStates >= batches);
+        ASSERT(host::counter().calls() <= 2 * batches);
+        ASSERT_EQ(host::counter().calls(), host::counter().getStates);
+#else
+        ASSERT_EQ(host::counter().getState, n);
+#endif
+        host::counter() = host::Counter();
+        for (CallList::ConstIterator iter = list.cbegin(); iter != list.cend(); ++iter) {
+            sum -= *iter;
+        }
+#ifdef ENABLE_STATE_EXT
+        ASSERT(host::counter().getStates >= batches);
+        ASSERT(host::counter().calls() <= 2 * batches);
+        ASSERT_EQ(host::counter().calls(), host::counter().getStates);
+#else
+        ASSERT_EQ(host::counter().getState, n);
+#endif
+        host::counter() = host::Counter();
+        for (int &v : list) {
+            sum += v;
+        }
+        for (int &v : list) {
+            sum -= v;
+        }
+#ifdef ENABLE_STATE_EXT
+        ASSERT(host::counter().getStates >= batches);
+        ASSERT(host::counter().calls() <= 2 * batches);
+        ASSERT_EQ(host::counter().calls(), host::counter().getStates);
+#else
+        ASSERT_EQ(host::counter().getState, n);
+#endif
+    }
+    ASSERT_EQ(sum, 0);
+}
+
+/**
+ * @brief Number of stored values that contain a string
+ *
+ */
+size_t stored(const std::string &value) {
+    size_t n = 0;
+    for (auto &iter : host::db()) {
+        if (iter.second.find(value) != std::string::npos) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Number of stored keys that contain a string
+ *
+ */
+size_t storedKeys(const std::string &key) {
+    size_t n = 0;
+    for (auto &iter : host::db()) {
+        if (iter.first.find(key) != std::string::npos) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+TEST_CASE(hostcalls, cleared) {
+    host::reset();
+    {
+        ClearMap map;
+        map["a"] = "VALA";
+        map["b"] = "VALB";
+    }
+    {
+        ClearMap map;
+        map.del("a");
+        map.clear();
+    }
+    {
+        ClearList list;
+        list.setCacheLimit(8);
+        for (int i = 0; i < 100; ++i) {
+            list.push("ELEM");
+        }
+        list.clear();
+    }
+    {
+        ClearValues values;
+        values.setCacheLimit(8);
+        for (int i = 0; i < 20; ++i) {
+            values.push("VALUE" + std::to_string(i % 3));
+        }
+        values[0] = "VALUE9";
+        values.clear();
+    }
+    // the elements spilled before clear() are stored, and sweep() has to reach them
+    ASSERT(stored("ELEM") > 0);
+    ASSERT(storedKeys(std::string(clearValuesName) + "V") > 0);
+    {
+        ClearMap map;
+        map.sweep(100);
+        ClearList list;
+        ASSERT_EQ(list.sweep(1000), 100);
+        ClearValues values;
+        ASSERT_EQ(values.sweep(1000), 20);
+    }
+    ASSERT_EQ(stored("VALA"), 0);
+    ASSERT_EQ(stored("VALB"), 0);
+    ASSERT_EQ(stored("ELEM"), 0);
+    ASSERT_EQ(storedKeys(std::string(clearValuesName) + "V"), 0);
+    ASSERT_EQ(storedKeys(std::string(clearValuesName) + "L"), 0);
+}
+
+UNITTEST_MAIN() {
+    RUN_TEST(hostcalls, getstates)
+    RUN_TEST(hostcalls, setstates)
+    RUN_TEST(hostcalls, buffer)
+    RUN_TEST(hostcalls, bytes)
+    RUN_TEST(hostcalls, reflush)
+    RUN_TEST(hostcalls, bloom)
+    RUN_TEST(hostcalls, list)
+    RUN_TEST(hostcalls, cleared)
+}
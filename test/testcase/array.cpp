@@ -9,10 +9,12 @@
 char arrayStrName[] = "arraystr";
 char arrayIntName[] = "arrayint";
 char arraySetName[] = "arrayset";
+char arrayClearName[] = "arrayclear";
 
 typedef platon::db::Array <arrayIntName, int, 20> ArrayInt;
 typedef platon::db::Array <arrayStrName, std::string, 2> ArrayStr;
 typedef platon::db::Array <arraySetName, std::string, 10> ArraySet;
+typedef platon::db::Array <arrayClearName, int, 4> ArrayClear;
 
 TEST_CASE(array, batch) {
     {
@@ -32,7 +34,7 @@ TEST_CASE(array, batch) {
         }
 
         for (size_t i = 10; i < 20; i++) {
-            ASSERT(arrayInt[i] == i, "array[", i, "]", arrayInt[i]);
+            ASSERT(arrayInt[i] == (int)i, "array[", i, "]", arrayInt[i]);
         }
     }
 
@@ -47,7 +49,7 @@ TEST_CASE(array, batch) {
 
         for (size_t i = 10; i < 20 && iter != arrayInt.end(); i++, iter++) {
             TRACE("i:", i, "iter:", *iter);
-            ASSERT(*iter == i, "iter:", *iter, "i:", i);
+            ASSERT(*iter == (int)i, "iter:", *iter, "i:", i);
         }
 
         ArrayInt::ConstIterator citer = arrayInt.cbegin();
@@ -58,7 +60,7 @@ TEST_CASE(array, batch) {
 
         for (size_t i = 10; i < 20 && citer != arrayInt.cend(); i++, citer++) {
             TRACE("i:", i, "iter:", *citer);
-            ASSERT(*citer == i, "iter:", *citer, "i:", i);
+            ASSERT(*citer == (int)i, "iter:", *citer, "i:", i);
         }
     }
 
@@ -72,24 +74,24 @@ TEST_CASE(array, batch) {
         }
 
         for (size_t i = 10; i < 20 && citer != arrayInt.cend(); i++, citer++) {
-            ASSERT(*citer == i, "iter:", *citer, "i:", i);
+            ASSERT(*citer == (int)i, "iter:", *citer, "i:", i);
         }
 
         ArrayInt::ReverseIterator iter = arrayInt.rbegin();
         for (size_t i = 19; i >= 10 && iter != arrayInt.rend(); i--, iter++) {
-            ASSERT(*iter == i, "iter:", *iter, "i:", i);
+            ASSERT(*iter == (int)i, "iter:", *iter, "i:", i);
         }
 
-        for (size_t i = 9; i >= 0 && iter != arrayInt.rend(); i--, iter++) {
+        for (int i = 9; i >= 0 && iter != arrayInt.rend(); i--, iter++) {
             ASSERT(*iter == 0, "iter:", *iter);
         }
 
         ArrayInt::ConstReverseIterator criter = arrayInt.crbegin();
         for (size_t i = 19; i >= 10 && criter != arrayInt.crend(); i--, ++criter) {
-            ASSERT(*criter == i, "criter:", *criter, "i:", i);
+            ASSERT(*criter == (int)i, "criter:", *criter, "i:", i);
         }
 
-        for (size_t i = 9; i >= 0 && criter != arrayInt.crend(); i--, criter++) {
+        for (int i = 9; i >= 0 && criter != arrayInt.crend(); i--, criter++) {
             ASSERT(*criter == 0, "criter:", *criter, "i:", i);
         }
     }
@@ -137,8 +139,48 @@ TEST_CASE(array, set) {
 
 
 
+TEST_CASE(array, clear) {
+    {
+        ArrayClear array;
+        for (size_t i = 0; i < array.size(); ++i) {
+            array[i] = i + 1;
+        }
+    }
+    {
+        ArrayClear array;
+        array.clear();
+        ASSERT_EQ(array[3], 0);
+        array[0] = 100;
+    }
+    ArrayClear array;
+    ASSERT_EQ(array[0], 100);
+    ASSERT_EQ(array[1], 0);
+    ASSERT_EQ(array.sweep(3), 3);
+    ASSERT_EQ(array.sweep(3), 1);
+    ASSERT_EQ(array.sweep(3), 0);
+}
+
+TEST_CASE(array, clean) {
+    {
+        ArrayClear array;
+        array[2] = 1;
+    }
+    {
+        ArrayClear reader;
+        ASSERT_EQ(reader[2], 1);
+        {
+            ArrayClear writer;
+            writer[2] = 2;
+        }
+    }
+    ArrayClear array;
+    ASSERT_EQ(array[2], 2);
+}
+
 UNITTEST_MAIN() {
     RUN_TEST(array, batch)
     RUN_TEST(array, open)
     RUN_TEST(array, set);
+    RUN_TEST(array, clear);
+    RUN_TEST(array, clean);
 }
@@ -0,0 +1,87 @@
+//
+// Double-ended queue over a ring of state slots
+//
+
+#include "platon/db/deque.hpp"
+#include "../unittest.hpp"
+
+char dequeName[] = "deque";
+
+typedef platon::db::Deque<dequeName, std::string> Tasks;
+
+TEST_CASE(deque, push) {
+    {
+        Tasks tasks;
+        ASSERT(tasks.empty());
+        tasks.push_back("b");
+        tasks.push_front("a");      // head wraps below slot 0
+        tasks.emplace_back(2, 'c');
+        ASSERT_EQ(tasks.size(), 3);
+        ASSERT_EQ(tasks.front(), "a");
+        ASSERT_EQ(tasks.back(), "cc");
+    }
+    {
+        Tasks tasks;
+        ASSERT_EQ(tasks.size(), 3);
+        ASSERT_EQ(tasks[0], "a");
+        ASSERT_EQ(tasks.getConst(1), "b");
+        tasks[1] += "b";
+        tasks.pop_front();
+        tasks.pop_back();
+        tasks.push_back("d");
+    }
+    Tasks tasks;
+    ASSERT_EQ(tasks.size(), 2);
+    ASSERT_EQ(tasks.front(), "bb");
+    ASSERT_EQ(tasks.back(), "d");
+}
+
+TEST_CASE(deque, queue) {
+    {
+        Tasks tasks;
+        tasks.clear();
+        tasks.setCacheLimit(8);
+        for (int i = 0; i < 100; ++i) {
+            tasks.push_back(std::to_string(i));
+        }
+        for (int i = 0; i < 60; ++i) {
+            ASSERT_EQ(tasks.front(), std::to_string(i));
+            tasks.pop_front();
+        }
+    }
+    Tasks tasks;
+    ASSERT_EQ(tasks.size(), 40);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        ASSERT_EQ(tasks.getConst(i), std::to_string(60 + i));
+    }
+    while (!tasks.empty()) {
+        tasks.pop_back();
+    }
+    ASSERT_EQ(tasks.size(), 0);
+}
+
+TEST_CASE(deque, reflush) {
+    {
+        Tasks tasks;
+        tasks.clear();
+        tasks.push_back("a");
+        tasks.push_back("b");
+        tasks.flush();
+        tasks.pop_back();
+        tasks.flush();
+        tasks.flush();
+        tasks.front() += "a";
+        tasks.flush();
+        tasks.push_back("c");
+    }
+    Tasks tasks;
+    ASSERT_EQ(tasks.size(), 2);
+    ASSERT_EQ(tasks.front(), "aa");
+    ASSERT_EQ(tasks.back(), "c");
+}
+
+UNITTEST_MAIN() {
+    RUN_TEST(deque, push)
+    RUN_TEST(deque, queue)
+    RUN_TEST(deque, reflush)
+}
@@ -0,0 +1,91 @@
+//
+// Map storing struct members under their own keys
+//
+
+#include "platon/db/fieldmap.hpp"
+#include "../unittest.hpp"
+
+struct Account {
+    uint64_t balance;
+    std::string profile;
+    std::vector<uint32_t> history;
+    PLATON_SERIALIZE(Account, (balance)(profile)(history))
+};
+
+struct Vault : public Account {
+    uint64_t locked;
+    PLATON_SERIALIZE_DERIVED(Vault, Account, (locked))
+};
+
+char accountName[] = "account";
+
+typedef platon::db::FieldMap<accountName, std::string, Account> Accounts;
+
+char vaultName[] = "vault";
+
+typedef platon::db::FieldMap<vaultName, int, Vault> Vaults;
+
+TEST_CASE(fieldmap, field) {
+    {
+        Accounts accounts;
+        accounts.insert("alice", Account{10, "profile", {1, 2}});
+        ASSERT(accounts.contains("alice"));
+        ASSERT(!accounts.contains("bob"));
+    }
+    {
+        Accounts accounts;
+        ASSERT_EQ(accounts.field("alice", &Account::balance), 10);
+        accounts.field("alice", &Account::balance) += 5;
+        // profile was never loaded, so this write survives the flush
+        platon::setState(std::make_tuple(Accounts::kType + accountName, std::string("alice"), (uint8_t)1),
+                         std::string("outside"));
+    }
+    Accounts accounts;
+    ASSERT_EQ(accounts["alice"].balance, 15);
+    ASSERT_EQ(accounts["alice"].profile, "outside");
+    ASSERT_EQ(accounts["alice"].history.size(), 2);
+}
+
+TEST_CASE(fieldmap, del) {
+    {
+        Vaults vaults;
+        Vault v;
+        v.balance = 1;
+        v.locked = 2;
+        vaults.insert(1, v);
+        vaults.field(2, &Vault::locked) = 3;
+    }
+    {
+        Vaults vaults;
+        ASSERT_EQ(vaults.field(1, &Vault::locked), 2);
+        ASSERT_EQ(vaults.field(2, &Vault::locked), 3);
+        ASSERT(vaults.contains(2));
+        vaults.del(1);
+        ASSERT(!vaults.contains(1));
+    }
+    Vaults vaults;
+    ASSERT(!vaults.contains(1));
+    ASSERT_EQ(vaults.get(1).balance, 0);
+}
+
+TEST_CASE(fieldmap, shared) {
+    {
+        Accounts first;
+        Accounts second;
+        first.field("carol", &Account::balance) = 1;
+        second.field("carol", &Account::balance) += 1;
+        ASSERT_EQ(first.field("carol", &Account::balance), 2);
+        second.del("carol");
+        ASSERT(!first.contains("carol"));
+        first.field("carol", &Account::balance) = 3;
+    }
+    Accounts accounts;
+    ASSERT_EQ(accounts.field("carol", &Account::balance), 3);
+    ASSERT_EQ(accounts["carol"].profile, "");
+}
+
+UNITTEST_MAIN() {
+    RUN_TEST(fieldmap, field)
+    RUN_TEST(fieldmap, del)
+    RUN_TEST(fieldmap, shared)
+}
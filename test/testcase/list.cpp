@@ -9,11 +9,24 @@ char listStrName[] = "liststr";
 char listIntName[] = "listint";
 char listPushName[] = "listPush";
 char listInsertName[] = "listInsert";
+char listClearName[] = "listClear";
+char listSpillName[] = "listSpill";
 
 typedef platon::db::List < listIntName, int > ListInt;
 typedef platon::db::List < listStrName, std::string > ListStr;
 typedef platon::db::List < listPushName, std::string > ListPush;
 typedef platon::db::List < listInsertName, std::string > ListInsert;
+typedef platon::db::List < listClearName, int > ListClear;
+typedef platon::db::List < listSpillName, int > ListSpill;
+
+char listValueName[] = "listValue";
+
+typedef platon::db::List < listValueName, std::string, platon::db::ListIndex::Value > ListValue;
+
+char listBuildName[] = "listBuild";
+
+typedef platon::db::List < listBuildName, std::string > ListPlain;
+typedef platon::db::List < listBuildName, std::string, platon::db::ListIndex::Value > ListBuild;
 
 TEST_CASE(list, push) {
     {
@@ -40,14 +53,14 @@ TEST_CASE(list, batch) {
             listInt.push(i);
         }
         for (size_t i = 0; i < 10; i++) {
-            listInt.del(i);
+            listInt.del(9 - i);
         }
     }
 
     {
         ListInt listInt;
         for (size_t i = 0; i < 10; i++) {
-            ASSERT(listInt[i] == i+10);
+            ASSERT(listInt[i] == (int)i+10);
         }
     }
 
@@ -131,9 +144,319 @@ TEST_CASE(list, insert){
 
 
 
+TEST_CASE(list, clear){
+    {
+        ListClear list;
+        for (int i = 0; i < 10; i++) {
+            list.push(i);
+        }
+    }
+    {
+        ListClear list;
+        list.clear();
+        ASSERT_EQ(list.size(), 0);
+        list.push(100);
+    }
+    ListClear list;
+    ASSERT_EQ(list.size(), 1);
+    ASSERT_EQ(list[0], 100);
+    ASSERT_EQ(list.sweep(8), 8);
+    ASSERT_EQ(list.sweep(8), 2);
+    ASSERT_EQ(list.sweep(8), 0);
+    ASSERT_EQ(list[0], 100);
+}
+
+TEST_CASE(list, clearspilled){
+    {
+        ListSpill list;
+        list.setCacheLimit(8);
+        for (int i = 0; i < 100; ++i) {
+            list.push(i);
+        }
+        list.clear();
+    }
+    ListSpill list;
+    ASSERT_EQ(list.size(), 0);
+    ASSERT_EQ(list.sweep(1000), 100);
+    ASSERT_EQ(list.sweep(1000), 0);
+}
+
+TEST_CASE(list, clean){
+    {
+        ListClear reader;
+        ASSERT_EQ(reader[0], 100);
+        {
+            ListClear writer;
+            writer[0] = 200;
+        }
+    }
+    ListClear list;
+    ASSERT_EQ(list[0], 200);
+}
+
+TEST_CASE(list, limit){
+    {
+        ListInt list;
+        list.clear();
+        list.setCacheLimit(8);
+        for (int i = 0; i < 100; ++i) {
+            list.push(i);
+        }
+        for (int i = 0; i < 100; ++i) {
+            list[i] += 1;
+        }
+        ASSERT_EQ(list[0], 1);
+    }
+    ListInt list;
+    ASSERT_EQ(list.size(), 100);
+    ASSERT_EQ(list[0], 1);
+    ASSERT_EQ(list[99], 100);
+}
+
+TEST_CASE(list, rank){
+    {
+        ListClear list;
+        list.clear();
+        for (int i = 0; i < 100; ++i) {
+            list.push(i);
+        }
+        for (size_t i = 0; i < 50; ++i) {
+            list.del(i);        // every even value
+        }
+        ASSERT_EQ(list.size(), 50);
+        ASSERT_EQ(list[0], 1);
+        ASSERT_EQ(list[49], 99);
+    }
+    ListClear list;
+    ASSERT_EQ(list.size(), 50);
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_EQ(list[i], 2 * i + 1);
+    }
+    list.del((size_t)10);
+    list.setConst(10, -1);
+    ASSERT_EQ(list.getConst(10), -1);
+    ASSERT_EQ(list[11], 25);
+}
+
+TEST_CASE(list, compact){
+    {
+        ListClear list;
+        list.clear();
+        for (int i = 0; i < 300; ++i) {
+            list.push(i);
+        }
+        for (int i = 0; i < 200; ++i) {
+            list.del((size_t)0);
+        }
+    }
+    {
+        // the flush moved 64 of the 100 elements
+        ListClear list;
+        ASSERT_EQ(list.size(), 100);
+        ASSERT_EQ(list[0], 200);
+        list[99] = -1;
+        ASSERT_EQ(list.compact(10), 10);
+        ASSERT_EQ(list[99], -1);
+        ASSERT_EQ(list.compact(100), 26);
+        ASSERT_EQ(list.compact(100), 0);
+        list.push(300);
+    }
+    ListClear list;
+    ASSERT_EQ(list.size(), 101);
+    for (int i = 0; i < 99; ++i) {
+        ASSERT_EQ(list[i], 200 + i);
+    }
+    ASSERT_EQ(list[99], -1);
+    ASSERT_EQ(list[100], 300);
+}
+
+TEST_CASE(list, value){
+    {
+        ListValue list;
+        list.push("alice");
+        list.push("bob");
+        list.push("carol");
+        list.push("bob");
+        ASSERT(list.contains("bob"));
+        ASSERT_EQ(list.indexOf("carol"), 2);
+        list[2] = "dave";
+        ASSERT(!list.contains("carol"));
+        ASSERT_EQ(list.indexOf("dave"), 2);
+    }
+    {
+        ListValue list;
+        ASSERT_EQ(list.indexOf("bob"), 1);
+        ASSERT_EQ(list.indexOf("carol"), list.size());
+        list.del(std::string("bob"));
+        ASSERT_EQ(list.size(), 2);
+        ASSERT(!list.contains("bob"));
+        ASSERT_EQ(list.indexOf("dave"), 1);
+        list.setConst(0, "erin");
+    }
+    ListValue list;
+    ASSERT(!list.contains("alice"));
+    ASSERT_EQ(list.indexOf("erin"), 0);
+    ASSERT_EQ(list.compact(10), 1);
+    ASSERT_EQ(list.indexOf("dave"), 1);
+    list.del((size_t)0);
+    ASSERT(!list.contains("erin"));
+    ASSERT_EQ(list.indexOf("dave"), 0);
+}
+
+TEST_CASE(list, build){
+    {
+        ListPlain list;
+        for (int i = 0; i < 10; ++i) {
+            list.push(std::to_string(i));
+        }
+        list.del((size_t)2);
+    }
+    {
+        ListBuild list;
+        ASSERT(!list.indexBuilt());
+        list[0] = "changed";
+        list.push("new");
+        ASSERT_EQ(list.buildIndex(4), 4);
+    }
+    {
+        ListBuild list;
+        ASSERT(!list.indexBuilt());
+        ASSERT_EQ(list.buildIndex(100), 6);
+        ASSERT(list.indexBuilt());
+        ASSERT_EQ(list.buildIndex(100), 0);
+        ASSERT(!list.contains("0"));
+        ASSERT(!list.contains("2"));
+        ASSERT_EQ(list.indexOf("changed"), 0);
+        ASSERT_EQ(list.indexOf("3"), 2);
+        ASSERT_EQ(list.indexOf("9"), 8);
+        ASSERT_EQ(list.indexOf("new"), 9);
+    }
+    ListBuild list;
+    ASSERT(list.indexBuilt());
+    list.del(std::string("5"));
+    ASSERT_EQ(list.size(), 9);
+    ASSERT_EQ(list.indexOf("6"), 4);
+}
+
+TEST_CASE(list, cursor){
+    {
+        ListClear list;
+        list.clear();
+        for (int i = 0; i < 100; ++i) {
+            list.push(i);
+        }
+        for (size_t i = 0; i < 50; ++i) {
+            list.del(i);
+        }
+    }
+    ListClear list;
+    std::vector<int> values;
+    for (int v : list.scan(8)) {
+        values.push_back(v);
+        if (v == 99) {
+            list.push(100);
+        }
+    }
+    ASSERT_EQ(values.size(), 51);
+    ASSERT_EQ(values[0], 1);
+    ASSERT_EQ(values[49], 99);
+    ASSERT_EQ(values[50], 100);
+    auto cursor = list.rscan(8);
+    ASSERT_EQ(cursor.value(), 100);
+    ASSERT_EQ(cursor.index(), 50);
+    cursor.next();
+    ASSERT_EQ(cursor.value(), 99);
+    size_t count = 0;
+    for (; cursor.valid(); cursor.next()) {
+        ++count;
+    }
+    ASSERT_EQ(count, 50);
+    ListClear::Iterator iter = list.begin();
+    ASSERT(iter++ == list.begin());
+    ASSERT(iter != list.begin());
+}
+
+TEST_CASE(list, shared){
+    {
+        ListClear first;
+        first.clear();
+        for (int i = 0; i < 300; ++i) {
+            first.push(i);
+        }
+        ListClear second;
+        ASSERT_EQ(second.size(), 300);
+        for (int i = 0; i < 200; ++i) {
+            second.del((size_t)0);
+        }
+        ASSERT_EQ(second.compact(100), 100);
+        ASSERT_EQ(first.size(), 100);
+        ASSERT_EQ(first[0], 200);
+        first.push(300);
+        ASSERT_EQ(second[100], 300);
+    }
+    ListClear list;
+    ASSERT_EQ(list.size(), 101);
+    for (int i = 0; i < 101; ++i) {
+        ASSERT_EQ(list[i], 200 + i);
+    }
+}
+
+TEST_CASE(list, iterate){
+    {
+        ListClear list;
+        list.clear();
+        for (int i = 0; i < 300; ++i) {
+            list.push(i);
+        }
+    }
+    {
+        ListClear list;
+        for (size_t i = 0; i < 100; ++i) {
+            list.del(i);        // every other element of the first 200
+        }
+        list.setCacheLimit(100);
+        int expect = 1;
+        for (int &v : list) {
+            ASSERT_EQ(v, expect);
+            v = -v;
+            expect += expect < 199 ? 2 : 1;
+        }
+        ASSERT_EQ(expect, 300);
+    }
+    ListClear list;
+    std::vector<int> values;
+    for (ListClear::ConstIterator iter = list.cbegin(); iter != list.cend(); ++iter) {
+        values.push_back(*iter);
+    }
+    ASSERT_EQ(values.size(), 200);
+    ASSERT_EQ(values[0], -1);
+    ASSERT_EQ(values[99], -199);
+    ASSERT_EQ(values[199], -299);
+    size_t n = values.size();
+    for (ListClear::ConstReverseIterator iter = list.crbegin(); iter != list.crend(); ++iter) {
+        ASSERT_EQ(*iter, values[--n]);
+    }
+    n = values.size();
+    for (ListClear::ReverseIterator iter = list.rbegin(); iter != list.rend(); ++iter) {
+        ASSERT_EQ(*iter, values[--n]);
+    }
+    ASSERT_EQ(n, 0);
+}
+
 UNITTEST_MAIN() {
     RUN_TEST(list, push)
     RUN_TEST(list, batch)
     RUN_TEST(list, opendel)
     RUN_TEST(list, insert)
+    RUN_TEST(list, clear)
+    RUN_TEST(list, clearspilled)
+    RUN_TEST(list, clean)
+    RUN_TEST(list, limit)
+    RUN_TEST(list, rank)
+    RUN_TEST(list, compact)
+    RUN_TEST(list, value)
+    RUN_TEST(list, build)
+    RUN_TEST(list, cursor)
+    RUN_TEST(list, shared)
+    RUN_TEST(list, iterate)
 }
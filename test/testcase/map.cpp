@@ -14,6 +14,36 @@ char mapInsertName[] = "mapinsert";
 
 typedef platon::db::Map<mapInsertName, std::string, std::string> MapInsert;
 
+char mapClearName[] = "mapclear";
+
+typedef platon::db::Map<mapClearName, std::string, std::string> MapClear;
+
+char mapIndexName[] = "mapindex";
+
+typedef platon::db::Map<mapIndexName, int, int> MapIndex;
+
+char mapBloomName[] = "mapbloom";
+
+typedef platon::db::Map<mapBloomName, std::string, std::string, platon::db::MapType::NoTraverse,
+        platon::db::MapKey::Plain, 1024> MapBloom;
+
+char mapCharsName[] = "mapchars";
+char mapHighName[] = "maphigh";
+
+typedef platon::db::Map<mapCharsName, std::vector<char>, int> MapChars;
+typedef platon::db::Map<mapHighName, std::string, int> MapHigh;
+
+char mapLegacyName[] = "maplegacy";
+
+typedef platon::db::Map<mapLegacyName, std::string, std::string, platon::db::MapType::NoTraverse> MapLegacy;
+typedef platon::db::Map<mapLegacyName, std::string, std::string, platon::db::MapType::NoTraverse,
+        platon::db::MapKey::Plain, 1024> MapLegacyBloom;
+
+char mapHashedName[] = "maphashed";
+
+typedef platon::db::Map<mapHashedName, std::string, std::string, platon::db::MapType::Traverse,
+        platon::db::MapKey::Hashed> MapHashed;
+
 TEST_CASE(map, operator) {
     {
         MapStr map;
@@ -106,7 +136,323 @@ TEST_CASE(map, insert) {
 
 
 
+TEST_CASE(map, hashed) {
+    std::string longKey(200, 'k');
+    {
+        MapHashed map;
+        map[longKey] = "long";
+        map["short"] = "short";
+    }
+
+    std::string name = MapHashed::kType + mapHashedName;
+    platon::StateDigest digest(MapHashed::KeyWrapper(name, longKey));
+    ASSERT_EQ(::getStateSize(digest.data(), digest.size()), platon::pack_size(std::string("long")));
+
+    MapHashed map;
+    ASSERT(map[longKey] == "long");
+    ASSERT(map.size() == 2);
+    std::vector<std::string> keys;
+    for (MapHashed::ConstIterator iter = map.cbegin(); iter != map.cend(); ++iter) {
+        keys.push_back(iter->first());
+    }
+    ASSERT(keys.size() == 2 && keys[0] == longKey && keys[1] == "short");
+    map.del(longKey);
+}
+
+TEST_CASE(map, clear) {
+    {
+        MapClear map;
+        for (int i = 0; i < 10; ++i) {
+            map[std::to_string(i)] = "value";
+        }
+    }
+    {
+        MapClear map;
+        map.clear();
+        ASSERT(map.size() == 0);
+        map["new"] = "value";
+    }
+    MapClear map;
+    ASSERT(map.size() == 1);
+    ASSERT(map.getConst("1") == "");
+    ASSERT(map.sweep(4) == 4);
+    ASSERT(map.sweep(100) == 7);
+    ASSERT(map.sweep(100) == 0);
+    ASSERT(map["new"] == "value");
+}
+
+TEST_CASE(map, contains) {
+    {
+        MapStr map;
+        ASSERT(map.contains("hello1"));
+        ASSERT(!map.contains("missing"));
+        map.del("hello1");
+        ASSERT(!map.contains("hello1"));
+        map.insert("hello1", "world");
+        ASSERT(map.exists("hello1"));
+    }
+    {
+        MapBloom map;
+        map.buildBloom();
+        for (int i = 0; i < 20; ++i) {
+            map.insert(std::to_string(i), "value");
+        }
+        map.insertConst("const", "value");
+        ASSERT(map.contains("const"));
+    }
+    MapBloom map;
+    for (int i = 0; i < 20; ++i) {
+        ASSERT(map.contains(std::to_string(i)));
+    }
+    ASSERT(map["19"] == "value");
+    ASSERT(map.contains("const"));
+    ASSERT(!map.contains("missing"));
+    ASSERT(map.getConst("missing") == "");
+}
+
+TEST_CASE(map, bloomlegacy) {
+    {
+        MapLegacy map;
+        map["x"] = "REAL";
+    }
+    {
+        MapLegacyBloom map;
+        ASSERT(!map.bloomBuilt());
+        ASSERT(map.contains("x"));
+        ASSERT(map["x"] == "REAL");
+        map["y"] = "NEW";
+    }
+    {
+        MapLegacyBloom map;
+        ASSERT(!map.bloomBuilt());
+        ASSERT(map.getConst("x") == "REAL");
+        ASSERT(map.getConst("y") == "NEW");
+        map.buildBloom({"x", "y"});
+    }
+    MapLegacyBloom map;
+    ASSERT(map.bloomBuilt());
+    ASSERT(map["x"] == "REAL");
+    ASSERT(map.contains("y"));
+    ASSERT(!map.contains("z"));
+    MapLegacy plain;
+    ASSERT(plain.getConst("x") == "REAL");
+}
+
+TEST_CASE(map, index) {
+    std::set<int> legacy;
+    for (int i = 0; i < 300; i += 2) {
+        legacy.insert(i);
+    }
+    platon::setState(MapIndex::kType + mapIndexName, legacy);
+    {
+        MapIndex map;
+        ASSERT(map.size() == legacy.size());
+        for (int i = 1; i < 300; i += 2) {
+            map.insert(i, i);
+        }
+        for (int i = 0; i < 300; i += 3) {
+            map.del(i);
+        }
+    }
+    ASSERT(!platon::hasState(MapIndex::kType + mapIndexName));
+
+    MapIndex map;
+    ASSERT(map.size() == 200);
+    int prev = -1;
+    size_t count = 0;
+    for (MapIndex::ConstIterator iter = map.cbegin(); iter != map.cend(); ++iter, ++count) {
+        ASSERT(iter->first() > prev && iter->first() % 3 != 0);
+        prev = iter->first();
+    }
+    ASSERT(count == 200);
+    ASSERT(map.contains(299) && !map.contains(297));
+
+    ASSERT(map.lower_bound(3)->first() == 4);
+    ASSERT(map.upper_bound(4)->first() == 5);
+    ASSERT(map.lower_bound(299)->first() == 299);
+    ASSERT(map.upper_bound(299) == map.cend());
+    count = 0;
+    for (MapIndex::Cursor cursor = map.range(10, 30, 4); cursor.valid(); cursor.next(), ++count) {
+        ASSERT(cursor.key() >= 10 && cursor.key() < 30);
+        ASSERT(cursor.key() % 2 == 0 || cursor.value() == cursor.key());
+    }
+    ASSERT(count == 14);
+    count = 0;
+    for (MapIndex::Cursor cursor = map.scan(); cursor.valid(); cursor.next()) {
+        ++count;
+    }
+    ASSERT(count == 200);
+}
+
+TEST_CASE(map, clean) {
+    {
+        MapInsert map;
+        map["clean"] = "read";
+        map["dirty"] = "read";
+    }
+    {
+        MapInsert map;
+        ASSERT(map["clean"] == "read");
+        map["dirty"] += "write";
+        // a clean entry is not written back, so this write survives the flush
+        platon::setState(MapInsert::KeyWrapper(MapInsert::kType + mapInsertName, "clean"), std::string("outside"));
+    }
+    MapInsert map;
+    ASSERT(map["clean"] == "outside");
+    ASSERT(map["dirty"] == "readwrite");
+}
+
+TEST_CASE(map, cache) {
+    {
+        MapIndex map;
+        for (int i = 1000; i < 1100; ++i) {
+            map[i] = i;
+        }
+        map.del(1000);
+        map[1000] = 1;
+        map.del(1001);
+    }
+    MapIndex map;
+    ASSERT(map.contains(1000));
+    ASSERT(!map.contains(1001));
+    ASSERT_EQ(map[1000], 1);
+    ASSERT_EQ(map[1099], 1099);
+}
+
+TEST_CASE(map, stringref) {
+    const char *key = "refkey";
+    {
+        MapInsert map;
+        map[key] = "value";
+        ASSERT(map.contains(key));
+        ASSERT(!map.contains("refmissing"));
+    }
+    MapInsert map;
+    ASSERT(map.contains(key));
+    ASSERT(map.getConst(platon::StringRef(key, 3)) == "");
+    ASSERT(map.getConst(key) == "value");
+    platon::bytes bytes(key, key + strlen(key));
+    ASSERT(map.get(bytes) == "value");
+
+    MapHashed hashed;
+    ASSERT(hashed.contains("short"));
+    ASSERT(hashed.getConst("short") == "short");
+    MapBloom bloom;
+    ASSERT(!bloom.contains(key));
+}
+
+TEST_CASE(map, highbytes) {
+    // std::vector<char> orders signed chars, a StringRef lookup would walk its key index wrongly
+    ASSERT(!platon::IsStringKey<std::vector<char>>::value);
+    {
+        MapChars chars;
+        MapHigh high;
+        for (int i = 0; i < 300; ++i) {
+            std::vector<char> key = {(char)(i * 7), (char)(i / 7)};
+            chars[key] = i;
+            high[std::string(key.begin(), key.end())] = i;
+        }
+    }
+    MapChars chars;
+    MapHigh high;
+    ASSERT_EQ(chars.size(), 300);
+    ASSERT_EQ(high.size(), 300);
+    for (int i = 0; i < 300; ++i) {
+        std::vector<char> key = {(char)(i * 7), (char)(i / 7)};
+        std::string str(key.begin(), key.end());
+        ASSERT(chars.contains(key));
+        ASSERT(high.contains(str));
+        ASSERT(high.contains(platon::StringRef(str)));
+        ASSERT_EQ(high.getConst(platon::StringRef(str)), i);
+        key[1] = (char)(key[1] + 100);
+        str[1] = (char)(str[1] + 100);
+        ASSERT(!chars.contains(key));
+        ASSERT(!high.contains(platon::StringRef(str)));
+    }
+    std::vector<char> last;
+    for (auto iter = chars.cbegin(); iter != chars.cend(); ++iter) {
+        ASSERT(last.empty() || last < iter->first());
+        last = iter->first();
+    }
+}
+
+TEST_CASE(map, shared) {
+    {
+        MapIndex first;
+        MapIndex second;
+        first[2000] = 1;
+        ASSERT_EQ(second[2000], 1);
+        second[2000] = 2;
+        ASSERT_EQ(first.getConst(2000), 2);
+    }
+    {
+        platon::StateScope scope;
+        {
+            MapIndex map;
+            map[2001] = 3;
+        }
+        MapIndex map;
+        ASSERT_EQ(map.getConst(2001), 3);
+    }
+    MapIndex map;
+    ASSERT_EQ(map[2000], 2);
+    ASSERT_EQ(map[2001], 3);
+}
+
+TEST_CASE(map, limit) {
+    {
+        MapIndex map;
+        map.setCacheLimit(16);
+        for (int i = 3000; i < 3500; ++i) {
+            map[i] = i;
+            map[3000] += 1;
+        }
+        map.del(3001);
+        for (int i = 3002; i < 3500; ++i) {
+            map[i] += 1;
+        }
+        ASSERT_EQ(map[3000], 3500);
+        ASSERT(!map.contains(3001));
+    }
+    MapIndex map;
+    ASSERT_EQ(map[3000], 3500);
+    ASSERT(!map.contains(3001));
+    ASSERT_EQ(map[3499], 3500);
+    ASSERT(map.contains(3250));
+}
+
+TEST_CASE(map, reflush) {
+    {
+        MapIndex map;
+        map[4000] = 1;
+        map[4001] = 1;
+        map.flush();
+        map.del(4001);
+        map.flush();
+        map.flush();
+        map[4000] += 1;
+        map.flush();
+        ASSERT(!map.contains(4001));
+        map[4001] = 3;
+    }
+    MapIndex map;
+    ASSERT_EQ(map[4000], 2);
+    ASSERT_EQ(map[4001], 3);
+}
+
 UNITTEST_MAIN() {
     RUN_TEST(map, operator);
     RUN_TEST(map, insert);
+    RUN_TEST(map, hashed);
+    RUN_TEST(map, clear);
+    RUN_TEST(map, contains);
+    RUN_TEST(map, bloomlegacy);
+    RUN_TEST(map, index);
+    RUN_TEST(map, clean);
+    RUN_TEST(map, cache);
+    RUN_TEST(map, stringref);
+    RUN_TEST(map, highbytes);
+    RUN_TEST(map, shared);
+    RUN_TEST(map, limit);
+    RUN_TEST(map, reflush);
 }
\ No newline at end of file
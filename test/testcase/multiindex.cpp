@@ -0,0 +1,92 @@
+//
+// Table with secondary indexes
+//
+
+#include "platon/db/multiindex.hpp"
+#include "../unittest.hpp"
+
+struct Task {
+    uint64_t id;
+    uint8_t status;
+    std::string owner;
+    std::string title() const { return owner + "-" + std::to_string(id); }
+    PLATON_SERIALIZE(Task, (id)(status)(owner))
+};
+
+char taskName[] = "task";
+
+typedef platon::db::MultiIndex<taskName, Task,
+        platon::db::IndexMember<Task, uint64_t, &Task::id>,
+        platon::db::IndexMember<Task, uint8_t, &Task::status>,
+        platon::db::IndexMethod<Task, std::string, &Task::title>> Tasks;
+
+TEST_CASE(multiindex, insert) {
+    {
+        Tasks tasks;
+        for (uint64_t i = 0; i < 100; ++i) {
+            ASSERT(tasks.insert(Task{i, (uint8_t)(i % 3), i < 50 ? "alice" : "bob"}));
+        }
+        ASSERT(!tasks.insert(Task{1, 2, "carol"}));
+        ASSERT_EQ(tasks.size(), 100);
+    }
+    Tasks tasks;
+    ASSERT_EQ(tasks.size(), 100);
+    ASSERT(tasks.contains(7));
+    ASSERT(!tasks.contains(100));
+    ASSERT(tasks.find(100) == nullptr);
+    ASSERT_EQ(tasks.find(7)->owner, "alice");
+    auto byStatus = tasks.index<0>();
+    ASSERT_EQ(byStatus.count(0), 34);
+    ASSERT_EQ(byStatus.count(2), 33);
+    uint64_t last = 0;
+    for (auto iter = byStatus.lower_bound(1); iter != byStatus.upper_bound(1); ++iter) {
+        ASSERT_EQ(iter.key(), 1);
+        ASSERT(iter.primaryKey() > last);
+        last = iter.primaryKey();
+    }
+    ASSERT_EQ(last, 97);
+    auto byTitle = tasks.index<1>();
+    ASSERT_EQ(byTitle.begin().key(), "alice-0");
+    ASSERT_EQ((--byTitle.end()).key(), "bob-99");
+}
+
+TEST_CASE(multiindex, modify) {
+    {
+        Tasks tasks;
+        ASSERT(tasks.modify(3, [](Task &t) { t.status = 2; }));
+        ASSERT(!tasks.modify(100, [](Task &t) { t.status = 2; }));
+        ASSERT(tasks.erase(4));
+        ASSERT(!tasks.erase(4));
+        ASSERT_EQ(tasks.index<0>().count(0), 33);
+    }
+    Tasks tasks;
+    ASSERT_EQ(tasks.size(), 99);
+    ASSERT(tasks.find(4) == nullptr);
+    ASSERT_EQ(tasks.find(3)->status, 2);
+    ASSERT_EQ(tasks.index<0>().count(2), 34);
+    auto range = tasks.index<1>().equal_range("alice-3");
+    ASSERT(range.first != range.second);
+    ASSERT_EQ(range.first.primaryKey(), 3);
+    ASSERT(tasks.index<1>().count("alice-4") == 0);
+}
+
+TEST_CASE(multiindex, shared) {
+    {
+        Tasks first;
+        Tasks second;
+        ASSERT(first.insert(Task{200, 1, "carol"}));
+        ASSERT(!second.insert(Task{200, 2, "carol"}));
+        ASSERT(second.modify(200, [](Task &t) { t.status = 2; }));
+        ASSERT_EQ(first.find(200)->status, 2);
+        ASSERT_EQ(first.size(), second.size());
+    }
+    Tasks tasks;
+    ASSERT_EQ(tasks.find(200)->status, 2);
+    ASSERT_EQ(tasks.index<0>().count(2), 35);
+}
+
+UNITTEST_MAIN() {
+    RUN_TEST(multiindex, insert)
+    RUN_TEST(multiindex, modify)
+    RUN_TEST(multiindex, shared)
+}
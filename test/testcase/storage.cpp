@@ -0,0 +1,270 @@
+//
+// State write buffer
+//
+
+#include "platon/storage.hpp"
+#include "platon/db/map.hpp"
+#include "platon/db/array.hpp"
+#include "platon/db/deque.hpp"
+#include "platon/db/list.hpp"
+#include "../unittest.hpp"
+
+char savepointMapName[] = "savepointmap";
+char savepointArrayName[] = "savepointarray";
+char savepointDequeName[] = "savepointdeque";
+char savepointListName[] = "savepointlist";
+char savepointHolesName[] = "savepointholes";
+
+typedef platon::db::Map<savepointMapName, std::string, std::string> SavepointMap;
+typedef platon::db::Array<savepointArrayName, int, 4> SavepointArray;
+typedef platon::db::Deque<savepointDequeName, int> SavepointDeque;
+typedef platon::db::List<savepointListName, int> SavepointList;
+typedef platon::db::List<savepointHolesName, int> SavepointHoles;
+
+/**
+ * @brief Length of the value stored on the blockchain, bypassing the buffer
+ */
+size_t hostSize(const std::string &key) {
+    std::vector<char> vecKey(platon::pack_size(key));
+    platon::DataStream<char*> keyStream(vecKey.data(), vecKey.size());
+    keyStream << key;
+    return ::getStateSize((const platon::byte*)vecKey.data(), vecKey.size());
+}
+
+TEST_CASE(buffer, write) {
+    std::string key = "bufferwrite";
+    {
+        platon::StateScope scope;
+        platon::setState(key, std::string("hello"));
+        platon::setState(key, std::string("world"));
+        ASSERT_EQ(hostSize(key), 0);
+
+        std::string value;
+        ASSERT(platon::getState(key, value) != 0);
+        ASSERT_EQ(value, "world");
+        ASSERT_EQ(platon::StateBuffer::instance().size(), 1);
+    }
+    ASSERT_EQ(platon::StateBuffer::instance().size(), 0);
+    ASSERT(hostSize(key) != 0);
+    std::string value;
+    platon::getState(key, value);
+    ASSERT_EQ(value, "world");
+}
+
+TEST_CASE(buffer, del) {
+    std::string key = "bufferdel";
+    platon::setState(key, std::string("hello"));
+    {
+        platon::StateScope scope;
+        platon::delState(key);
+        std::string value;
+        ASSERT_EQ(platon::getState(key, value), 0);
+        ASSERT(hostSize(key) != 0);
+        {
+            platon::StateScope nested;
+            platon::setState(key, std::string("nested"));
+        }
+        ASSERT(platon::StateBuffer::instance().active());
+        platon::delState(key);
+    }
+    ASSERT_EQ(hostSize(key), 0);
+}
+
+TEST_CASE(state, bytes) {
+    std::string key = "statebytes";
+    std::string large(1000, 'a');
+    platon::setState(key, large);
+    std::string value;
+    ASSERT_EQ(platon::getState(key, value), platon::pack_size(large));
+    ASSERT_EQ(value, large);
+
+    char buf[8];
+    ASSERT_EQ(platon::getStateBytes(key, buf, sizeof(buf)), platon::pack_size(large));
+    ASSERT_EQ(std::string(buf, sizeof(buf)), platon::encodeState(large).substr(0, sizeof(buf)));
+
+    platon::setState(key, std::string("small"));
+    ASSERT_EQ(platon::getStateBytes(key, buf, sizeof(buf)), 6);
+    ASSERT_EQ(std::string(buf + 1, 5), "small");
+    ASSERT_EQ(platon::getStateBytes(std::string("statemissing"), buf, sizeof(buf)), 0);
+}
+
+TEST_CASE(cache, read) {
+    std::string key = "cacheread";
+    platon::StateCache &cache = platon::StateCache::instance();
+    platon::setState(key, std::string("hello"));
+    cache.enable();
+    size_t hits = cache.hits();
+    size_t misses = cache.misses();
+
+    std::string value;
+    platon::getState(key, value);
+    platon::getState(key, value);
+    ASSERT_EQ(value, "hello");
+    ASSERT_EQ(cache.misses(), misses + 1);
+    ASSERT_EQ(cache.hits(), hits + 1);
+
+    platon::setState(key, std::string("world"));
+    platon::getState(key, value);
+    ASSERT_EQ(value, "world");
+    ASSERT_EQ(cache.misses(), misses + 2);
+
+    platon::delState(key);
+    ASSERT_EQ(platon::getState(key, value), 0);
+    ASSERT_EQ(platon::getState(key, value), 0);
+    ASSERT_EQ(cache.hits(), hits + 2);
+    cache.enable(false);
+}
+
+TEST_CASE(state, batch) {
+    std::vector<std::string> keys = {"batch1", "batch2", "batchmissing", "batch3"};
+    platon::setState(keys[0], 1);
+    platon::setState(keys[1], 2);
+    std::vector<int> values;
+    {
+        platon::StateScope scope;
+        platon::setState(keys[3], 3);
+        ASSERT_EQ(platon::getStates(keys, values), 3);
+    }
+    ASSERT_EQ(values.size(), 4);
+    ASSERT_EQ(values[0], 1);
+    ASSERT_EQ(values[1], 2);
+    ASSERT_EQ(values[2], 0);
+    ASSERT_EQ(values[3], 3);
+}
+
+TEST_CASE(savepoint, rollback) {
+    std::string key = "savepoint";
+    std::string inner = "savepointinner";
+    platon::setState(key, std::string("origin"));
+    std::string value;
+    {
+        platon::Savepoint sp;
+        platon::setState(key, std::string("outer"));
+        {
+            platon::Savepoint nested;
+            platon::setState(key, std::string("nested"));
+            platon::setState(inner, std::string("nested"));
+            nested.rollback();
+            platon::getState(key, value);
+            ASSERT_EQ(value, "outer");
+            ASSERT_EQ(platon::getState(inner, value), 0);
+
+            platon::delState(key);
+        }
+        ASSERT_EQ(platon::getState(key, value), 0);
+        sp.rollback();
+        platon::getState(key, value);
+        ASSERT_EQ(value, "origin");
+        platon::setState(inner, std::string("kept"));
+    }
+    ASSERT_EQ(platon::StateBuffer::instance().size(), 0);
+    ASSERT(hostSize(inner) != 0);
+    platon::getState(key, value);
+    ASSERT_EQ(value, "origin");
+}
+
+TEST_CASE(savepoint, containers) {
+    {
+        platon::StateScope call;
+        SavepointMap kept;
+        kept["b"] = "before";
+        {
+            platon::Savepoint sp;
+            {
+                SavepointMap map;
+                map.insert("a", "speculative");
+                map["b"] = "changed";
+                SavepointArray array;
+                array[1] = 7;
+                SavepointDeque deque;
+                deque.push_back(1);
+                SavepointList list;
+                list.push(1);
+            }
+            kept.clear();
+            sp.rollback();
+            // the caches shared with kept are read again
+            ASSERT(!kept.contains("a"));
+            ASSERT_EQ(kept["b"], "before");
+            SavepointArray array;
+            ASSERT_EQ(array[1], 0);
+            SavepointDeque deque;
+            ASSERT(deque.empty());
+            deque.push_back(2);
+            SavepointList list;
+            ASSERT_EQ(list.size(), 0);
+        }
+    }
+    SavepointMap map;
+    ASSERT(!map.contains("a"));
+    ASSERT_EQ(map.getConst("b"), "before");
+    ASSERT_EQ(map.size(), 1);
+    SavepointArray array;
+    ASSERT_EQ(array.getConst(1), 0);
+    SavepointDeque deque;
+    ASSERT_EQ(deque.size(), 1);
+    ASSERT_EQ(deque.front(), 2);
+    SavepointList list;
+    ASSERT_EQ(list.size(), 0);
+}
+
+TEST_CASE(savepoint, references) {
+    {
+        SavepointHoles list;
+        for (int i = 0; i < 300; ++i) {
+            list.push(i);
+        }
+        for (int i = 0; i < 200; ++i) {
+            list.del((size_t)0);
+        }
+    }
+    {
+        platon::StateScope call;
+        SavepointHoles list;
+        int &first = list[0];
+        {
+            // the flush of the savepoint must not compact the list under the reference
+            platon::Savepoint sp;
+        }
+        first = 777;
+    }
+    SavepointHoles list;
+    ASSERT_EQ(list.size(), 100);
+    ASSERT_EQ(list[0], 777);
+    ASSERT_EQ(list[1], 201);
+}
+
+TEST_CASE(state, has) {
+    std::string key = "statehas";
+    ASSERT(!platon::hasState(key));
+    platon::setState(key, std::string("hello"));
+    ASSERT(platon::hasState(key));
+    {
+        platon::StateScope scope;
+        platon::delState(key);
+        ASSERT(!platon::hasState(key));
+    }
+    ASSERT(!platon::hasState(key));
+}
+
+TEST_CASE(state, joined) {
+    std::string id = "01";
+    platon::setState(std::string("joined") + id, std::string("hello"));
+    std::string value;
+    ASSERT(platon::getState(platon::JoinedKey("joined", id), value) != 0);
+    ASSERT_EQ(value, "hello");
+    ASSERT(platon::hasState(platon::StringRef("joined01")));
+}
+
+UNITTEST_MAIN() {
+    RUN_TEST(buffer, write)
+    RUN_TEST(buffer, del)
+    RUN_TEST(state, bytes)
+    RUN_TEST(cache, read)
+    RUN_TEST(state, batch)
+    RUN_TEST(savepoint, rollback)
+    RUN_TEST(savepoint, containers)
+    RUN_TEST(savepoint, references)
+    RUN_TEST(state, has)
+    RUN_TEST(state, joined)
+}
@@ -17,7 +17,7 @@
             platon::StorageType<STORAGE_NAME(TYPE), BASETYPE> v(STORAGE); \
         } \
         platon::StorageType<STORAGE_NAME(TYPE), BASETYPE> v2(STORAGE); \
-        ASSERT(v2 == STORAGE);\
+        ASSERT(v2 == BASETYPE(STORAGE));\
     }
 
 SET_GET(uint8_t, uint8_t, 1)
@@ -30,6 +30,18 @@ SET_GET(uint64_t, uint64_t, 1)
 SET_GET(int64_t, int64_t, 1)
 SET_GET(string, std::string, "hello")
 
+char sNamespace[] = "namespace";
+PLATON_STATE_ID(sNamespace, 0x0102)
+
+TEST_CASE(SetGet, namespace) {
+    {
+        platon::StorageType<sNamespace, std::string> v(std::string("hello"));
+    }
+    std::string value;
+    ASSERT(platon::getState(std::string("s\0\0\1\2", 5), value) != 0);
+    ASSERT(value == "hello");
+}
+
 
 UNITTEST_MAIN() {
     RUN_TEST(SetGet, uint8_t)
@@ -41,4 +53,5 @@ UNITTEST_MAIN() {
     RUN_TEST(SetGet, uint64_t)
     RUN_TEST(SetGet, int64_t)
     RUN_TEST(SetGet, string)
+    RUN_TEST(SetGet, namespace)
 }
@@ -62,16 +62,16 @@ if (!testResult_.skip) {\
 
 
 
-//#define TEST_SUIT() \
+//#define TEST_SUIT()
 //    void testSuit(TestResult &testResult)
 
 #define UNITTEST_MAIN() \
 void testSuit(TestResult &testResult);\
-int main(int argc, char *argv[]) { \
+int main() { \
     TestResult testResult; \
     testResult.isContinue = true; \
     testSuit(testResult); \
     platon::println(testResult.testcases, "tests,", testResult.assertions, "assertions,", testResult.failures, "failures" ); \
     return 0; \
 } \
-void testSuit(TestResult &testResult)
\ No newline at end of file
+void testSuit(TestResult &testResult)
@@ -52,6 +52,11 @@ namespace mpc {
 
 class MPC : public platon::Contract {
     public:
+        MPC() {
+            // is_partner, set_result and the getters read the same keys several times per call
+            platon::StateCache::instance().enable();
+        }
+
 		// define event.
         PLATON_EVENT(start_calc_event, uint64_t, const char *)
         PLATON_EVENT(set_result_event, uint64_t, const char *)
@@ -148,9 +153,7 @@ class MPC : public platon::Contract {
 
             std::string key_str = PREFIX_RESULT_MAP + std::string(taskId);
             // check result set
-            std::string res_value_str;
-            platon::getState(key_str, res_value_str);
-            if(res_value_str.length() > 1){
+            if(platon::hasState(key_str)){
                 platon::println("set_result-> set already. Can not reset again.");
                 PLATON_EMIT_EVENT(start_calc_event, 0, "set already. Can not reset again.");
                 return;
@@ -218,16 +221,13 @@ class MPC : public platon::Contract {
 
         const char * get_url_by_id(const char *id) const {
             std::string url;
-            std::string key_str = KEY_URLS + std::string(id);
-            platon::getState(key_str, url);
+            platon::getState(platon::JoinedKey(KEY_URLS, id), url);
             return url.c_str();
         }
 
         const char * get_result(const char *task_id) const {
-            std::string id_str = std::string(task_id);
-            std::string key_str = PREFIX_RESULT_MAP + std::string(id_str);
             std::string result;
-            platon::getState(key_str, result);
+            platon::getState(platon::JoinedKey(PREFIX_RESULT_MAP, task_id), result);
 			// std::string value_str = status_str + COMMON_SPLIT_CHAR + data_str;
 			std::vector<std::string> partner_vec = split(result, COMMON_SPLIT_CHAR);
 			if(partner_vec.size() != 2) {
@@ -237,10 +237,8 @@ class MPC : public platon::Contract {
         }
 
 		uint64_t get_status(const char *task_id) const {
-			std::string id_str = std::string(task_id);
-            std::string key_str = PREFIX_RESULT_MAP + std::string(id_str);
             std::string result;
-            platon::getState(key_str, result);
+            platon::getState(platon::JoinedKey(PREFIX_RESULT_MAP, task_id), result);
 			std::vector<std::string> partner_vec = split(result, COMMON_SPLIT_CHAR);
 			if(partner_vec.size() != 2) {
 				return 0;
@@ -251,8 +249,7 @@ class MPC : public platon::Contract {
 
         const char* get_fee(const char* method) const {
             platon::u256 fee;
-            std::string key_str = KEY_METHOD_PRICE + std::string(method);
-            platon::getState(key_str, fee);
+            platon::getState(platon::JoinedKey(KEY_METHOD_PRICE, method), fee);
             platon::println("call get_fee. - ", fee.convert_to<std::string>());
             return fee.convert_to<std::string>().c_str();
         }
@@ -335,9 +332,8 @@ class MPC : public platon::Contract {
         }
 
         platon::u256 get_saved_amount(const char *task_id) {
-            std::string key_str = PREFIX_ALLOT_MAP + std::string(task_id);
             platon::u256 value_u;
-            platon::getState(key_str, value_u);
+            platon::getState(platon::JoinedKey(PREFIX_ALLOT_MAP, task_id), value_u);
             platon::println("get_saved_amout: ", value_u.convert_to<std::string>());
             return value_u;
         }